@@ -34,6 +34,8 @@
 #include <string.h>
 #include <sys/time.h>
 #include <pthread.h>
+#include <stdbool.h>
+#include <limits.h>
 
 /* ************* */
 /* Some defines. */
@@ -46,12 +48,16 @@
 #define MAX_INTERLINES    10240
 #define MAX_ITERATION     200000
 #define MAX_THREADS       1024
+#define MAX_TILING        64
 #define METH_GAUSS_SEIDEL 1
 #define METH_JACOBI       2
 #define FUNC_F0           1
 #define FUNC_FPISIN       2
 #define TERM_PREC         1
 #define TERM_ITER         2
+
+/* --bench: 97,5-%-Quantile der t-Verteilung bis zu so vielen Freiheitsgraden, darüber 1,96 */
+#define BENCH_T 30
 typedef void * (*THREADFUNCPTR)(void *);
 
 struct calculation_arguments
@@ -67,6 +73,7 @@ struct calculation_results
 	uint64_t m;
 	uint64_t stat_iteration; /* number of current iteration */
 	double   stat_precision; /* actual precision of all slaves in iteration */
+	double   bench[5];       /* --bench: median, mean and standard deviation of the solve time, 95 % confidence interval */
 };
 
 struct options
@@ -78,6 +85,8 @@ struct options
 	uint64_t termination;    /* termination condition */
 	uint64_t term_iteration; /* terminate if iteration number reached */
 	double   term_precision; /* terminate if precision reached */
+	uint64_t tiling;         /* depth of temporal tiling (0: plain sweeps) */
+	int      bench[2];       /* measured and warmup runs of --bench (0: solve once) */
 };
 
 /* ************************************************************************ */
@@ -91,7 +100,7 @@ struct timeval comp_time;  /* time when calculation completed */
 static void
 usage(char* name)
 {
-	printf("Usage: %s [num] [method] [lines] [func] [term] [prec/iter]\n", name);
+	printf("Usage: %s [num] [method] [lines] [func] [term] [prec/iter] [tiling] [--bench=R[,W]]\n", name);
 	printf("\n");
 	printf("  - num:       number of threads (1 .. %d)\n", MAX_THREADS);
 	printf("  - method:    calculation method (1 .. 2)\n");
@@ -108,6 +117,13 @@ usage(char* name)
 	printf("  - prec/iter: depending on term:\n");
 	printf("                 precision:  1e-4 .. 1e-20\n");
 	printf("                 iterations:    1 .. %d\n", MAX_ITERATION);
+	printf("  - tiling:    optional depth of temporal tiling (0 .. %d)\n", MAX_TILING);
+	printf("                 0: plain sweeps (default)\n");
+	printf("                 n: each thread advances n Jacobi iterations per sweep\n");
+	printf("                    (only Jacobi with a number of iterations)\n");
+	printf("  - --bench=R[,W]: solve W + R times in one process (default W: 1) and report\n");
+	printf("                 median, mean, standard deviation and 95 %% confidence interval\n");
+	printf("                 of the last R solve times, plus a CSV row\n");
 	printf("\n");
 	printf("Example: %s 1 2 100 1 2 100 \n", name);
 }
@@ -187,6 +203,62 @@ askParams(struct options* options, int argc, char** argv)
 			exit(1);
 		}
 	}
+
+	options->tiling   = 0;
+	options->bench[0] = 0;
+	options->bench[1] = 1;
+
+	/* optionales --bench=R[,W] als letztes Argument */
+	if (argc > 7 && strncmp(argv[argc - 1], "--bench=", 8) == 0)
+	{
+		ret = sscanf(argv[argc - 1] + 8, "%d,%d", &(options->bench[0]), &(options->bench[1]));
+
+		if (ret < 1 || options->bench[0] < 1 || options->bench[1] < 0)
+		{
+			usage(argv[0]);
+			exit(1);
+		}
+
+		argc--;
+	}
+
+	if (argc > 8)
+	{
+		usage(argv[0]);
+		exit(1);
+	}
+
+	if (argc > 7)
+	{
+		ret = sscanf(argv[7], "%" SCNu64, &(options->tiling));
+
+		if (ret != 1 || !(options->tiling <= MAX_TILING))
+		{
+			usage(argv[0]);
+			exit(1);
+		}
+
+		/* temporal tiling needs Jacobi and the number of iterations in advance */
+		if (options->tiling > 0 && (options->method != METH_JACOBI || options->termination != TERM_ITER))
+		{
+			printf("Temporal Tiling geht nur mit Jacobi und Abbruch nach Anzahl der Iterationen\n\n");
+			usage(argv[0]);
+			exit(1);
+		}
+	}
+}
+
+/* ************************************************************************ */
+/* initResults: resets the results before every calculation                 */
+/* ************************************************************************ */
+static void
+initResults(struct calculation_results* results)
+{
+	results->m              = 0;
+	results->stat_iteration = 0;
+	results->stat_precision = 0;
+
+	memset(results->bench, 0, sizeof(results->bench));
 }
 
 /* ************************************************************************ */
@@ -199,9 +271,7 @@ initVariables(struct calculation_arguments* arguments, struct calculation_result
 	arguments->num_matrices = (options->method == METH_JACOBI) ? 2 : 1;
 	arguments->h            = 1.0 / arguments->N;
 
-	results->m              = 0;
-	results->stat_iteration = 0;
-	results->stat_precision = 0;
+	initResults(results);
 }
 
 /* ************************************************************************ */
@@ -299,7 +369,7 @@ struct thread_arguments{
         int m1;
         int m2;
         double star;
-        int residuum;
+        double residuum;
         double pih;
         double fpisin;
 
@@ -327,7 +397,7 @@ void *thread_calculate(void *passed_arguments)
         int i, j;
         int m1 = arguments->m1;
         int m2 = arguments->m2;
-        int fpisin = arguments->fpisin;
+        double fpisin = arguments->fpisin;
         double pih = arguments->pih;
         int inf_func = arguments->inf_func;
         int const N = arguments->N;
@@ -440,22 +510,16 @@ calculate(struct calculation_arguments const* arguments, struct calculation_resu
 			t_arguments[i].thread_id = i;
 
 	
-			if(i == 0)
-			{	
-				/* first has to start with one */
-				t_arguments[i].row_start = 1;
-			} else
-			{
-				t_arguments[i].row_start = row_size * i;				
-			}
+			/* first has to start with one */
+			t_arguments[i].row_start = 1 + row_size * i;
 
 			if(i != options->number - 1)
 			{	
-				/* start of next thread - 1 */
-				t_arguments[i].row_end = row_size *(i + 1) - 1;
+				/* start of next thread (exclusive) */
+				t_arguments[i].row_end = 1 + row_size * (i + 1);
 			} else{
 				/* last gets all remaining rows */
-				t_arguments[i].row_end = N - 1;
+				t_arguments[i].row_end = N;
 			} 
 		
 			t_arguments[i].m1 = m1;
@@ -463,7 +527,8 @@ calculate(struct calculation_arguments const* arguments, struct calculation_resu
 			t_arguments[i].pih = pih;
 			t_arguments[i].fpisin = fpisin;
 			t_arguments[i].inf_func = options->inf_func;
-			t_arguments[i].termination = options->termination;;
+			t_arguments[i].termination = options->termination;
+			t_arguments[i].term_iteration = term_iteration;
 			t_arguments[i].N = N;
 			t_arguments[i].Matrix = (double***)  Matrix;
 					
@@ -508,6 +573,256 @@ calculate(struct calculation_arguments const* arguments, struct calculation_resu
         results->m = m2;
 }
 
+/* progress of a thread in the tiled solver, guarded by its own mutex */
+struct tile_progress{
+	pthread_mutex_t mutex;
+	pthread_cond_t  cond;
+
+	/* number of finished wavefronts, counted over all rounds */
+	long done;
+};
+
+/* struct for parameters of the tiled solver threads */
+struct tile_arguments{
+	int thread_id;
+	int threads;
+	int depth;
+	int N;
+
+	/* total number of iterations */
+	uint64_t iterations;
+
+	int inf_func;
+	double pih;
+	double fpisin;
+
+	/* maximum residuum of the last iteration (if computed by this thread) */
+	double residuum;
+
+	double* M;
+
+	/* progress of all threads, indexed by thread id */
+	struct tile_progress* progress;
+};
+
+/* ************************************************************************ */
+/* tile_wait: blocks until thread id has finished at least done wavefronts  */
+/* ************************************************************************ */
+static void
+tile_wait(struct tile_progress* progress, long done)
+{
+	pthread_mutex_lock(&progress->mutex);
+
+	while (progress->done < done)
+	{
+		pthread_cond_wait(&progress->cond, &progress->mutex);
+	}
+
+	pthread_mutex_unlock(&progress->mutex);
+}
+
+/* ************************************************************************ */
+/* tile_publish: announces that the calling thread finished done wavefronts */
+/* ************************************************************************ */
+static void
+tile_publish(struct tile_progress* progress, long done)
+{
+	pthread_mutex_lock(&progress->mutex);
+	progress->done = done;
+	pthread_cond_broadcast(&progress->cond);
+	pthread_mutex_unlock(&progress->mutex);
+}
+
+/* ************************************************************************ */
+/* thread_calculate_tiled: method used by threads of the tiled solver       */
+/*                                                                          */
+/* The iterations are cut into blocks of depth iterations. Block b belongs  */
+/* to thread b % threads, so the threads form a ring in which each thread   */
+/* continues the iterations of its predecessor. A block is computed as one  */
+/* skewed wavefront over all rows: at wavefront w, iteration s of the block */
+/* updates row w - s. The rows touched by one wavefront stay in the cache   */
+/* until all depth iterations are done with them.                           */
+/*                                                                          */
+/* Row i of the first iteration of a block needs row i + 1 of the last      */
+/* iteration of the predecessor's block and overwrites row i of the         */
+/* iteration before that, so a thread may compute wavefront w once its      */
+/* predecessor finished wavefront w + depth. No other synchronization is    */
+/* needed and the results are identical to plain sweeps.                    */
+/* ************************************************************************ */
+void *thread_calculate_tiled(void *passed_arguments)
+{
+	struct tile_arguments *arguments;
+	arguments = (struct tile_arguments *) passed_arguments;
+
+	int const N = arguments->N;
+	int const threads = arguments->threads;
+	int const depth = arguments->depth;
+	uint64_t const iterations = arguments->iterations;
+
+	/* number of wavefronts of a full block */
+	long const wavefronts = (N - 1) + (depth - 1);
+
+	int const predecessor = (arguments->thread_id + threads - 1) % threads;
+
+	int i, j, s, w;
+	double star;
+	double residuum;
+	double maxresiduum = 0;
+
+	typedef double(*matrix)[N + 1][N + 1];
+	matrix Matrix = (matrix) arguments->M;
+
+	for (long round = 0; ; round++)
+	{
+		uint64_t const block = round * threads + arguments->thread_id;
+		uint64_t const first = block * depth;
+
+		if (first >= iterations)
+		{
+			break;
+		}
+
+		/* the last block may be shorter */
+		int const count = (iterations - first < (uint64_t)depth) ? (int)(iterations - first) : depth;
+
+		/* the predecessor of the first block of all works on the initial matrix */
+		bool const dependent = (block > 0);
+		long const predecessor_round = (arguments->thread_id == 0) ? round - 1 : round;
+
+		for (w = 1; w < (N - 1) + count; w++)
+		{
+			if (dependent)
+			{
+				long const needed = (w + depth < wavefronts) ? w + depth : wavefronts;
+				tile_wait(&arguments->progress[predecessor], predecessor_round * wavefronts + needed);
+			}
+
+			for (s = 0; s < count; s++)
+			{
+				uint64_t const iteration = first + s + 1;
+
+				/* iteration k writes matrix (k - 1) % 2 and reads matrix k % 2 */
+				int const m1 = (iteration - 1) % 2;
+				int const m2 = iteration % 2;
+
+				i = w - s;
+
+				if (i < 1 || i > N - 1)
+				{
+					continue;
+				}
+
+				double fpisin_i = 0;
+
+				if (arguments->inf_func == FUNC_FPISIN)
+				{
+					fpisin_i = arguments->fpisin * sin(arguments->pih * (double)i);
+				}
+
+				/* over all columns */
+				for (j = 1; j < N; j++)
+				{
+					star = 0.25 * (Matrix[m2][i - 1][j] + Matrix[m2][i][j - 1] + Matrix[m2][i][j + 1] + Matrix[m2][i + 1][j]);
+
+					if (arguments->inf_func == FUNC_FPISIN)
+					{
+						star += fpisin_i * sin(arguments->pih * (double)j);
+					}
+
+					if (iteration == iterations)
+					{
+						residuum    = Matrix[m2][i][j] - star;
+						residuum    = fabs(residuum);
+						maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+					}
+
+					Matrix[m1][i][j] = star;
+				}
+			}
+
+			tile_publish(&arguments->progress[arguments->thread_id], round * wavefronts + w);
+		}
+
+		tile_publish(&arguments->progress[arguments->thread_id], (round + 1) * wavefronts);
+	}
+
+	/* no more blocks, never let the successor wait */
+	tile_publish(&arguments->progress[arguments->thread_id], LONG_MAX);
+
+	arguments->residuum = maxresiduum;
+
+	return NULL;
+}
+
+/* ************************************************************************ */
+/* calculate_tiled: solves the equation for Jacobi with temporal tiling     */
+/* ************************************************************************ */
+static void
+calculate_tiled(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
+{
+	uint64_t i;
+	double maxresiduum = 0;
+
+	double const h = arguments->h;
+
+	double pih    = 0.0;
+	double fpisin = 0.0;
+
+	struct tile_arguments t_arguments[options->number];
+	struct tile_progress progress[options->number];
+	pthread_t threads[options->number];
+
+	if (options->inf_func == FUNC_FPISIN)
+	{
+		pih    = M_PI * h;
+		fpisin = 0.25 * (2 * M_PI * M_PI) * h * h;
+	}
+
+	for (i = 0; i < options->number; i++)
+	{
+		pthread_mutex_init(&progress[i].mutex, NULL);
+		pthread_cond_init(&progress[i].cond, NULL);
+		progress[i].done = 0;
+	}
+
+	/* threads live for the whole calculation */
+	for (i = 0; i < options->number; i++)
+	{
+		t_arguments[i].thread_id = i;
+		t_arguments[i].threads = options->number;
+		t_arguments[i].depth = options->tiling;
+		t_arguments[i].N = arguments->N;
+		t_arguments[i].iterations = options->term_iteration;
+		t_arguments[i].inf_func = options->inf_func;
+		t_arguments[i].pih = pih;
+		t_arguments[i].fpisin = fpisin;
+		t_arguments[i].residuum = 0;
+		t_arguments[i].M = arguments->M;
+		t_arguments[i].progress = progress;
+
+		int rc;
+		rc = pthread_create(&threads[i], NULL, thread_calculate_tiled, &t_arguments[i]);
+		if (rc){
+			printf("ERROR; return code from pthread_create() is %d\n", rc);
+			exit(-1);
+		}
+	}
+
+	/* only the thread computing the last iteration has a residuum */
+	for (i = 0; i < options->number; i++)
+	{
+		pthread_join(threads[i], NULL);
+		maxresiduum = (t_arguments[i].residuum < maxresiduum) ? maxresiduum : t_arguments[i].residuum;
+
+		pthread_mutex_destroy(&progress[i].mutex);
+		pthread_cond_destroy(&progress[i].cond);
+	}
+
+	results->stat_iteration = options->term_iteration;
+	results->stat_precision = maxresiduum;
+	results->m = (options->term_iteration - 1) % 2;
+}
+
 /* ************************************************************************ */
 /*  displayStatistics: displays some statistics about the calculation       */
 /* ************************************************************************ */
@@ -518,6 +833,14 @@ displayStatistics(struct calculation_arguments const* arguments, struct calculat
 	double time = (comp_time.tv_sec - start_time.tv_sec) + (comp_time.tv_usec - start_time.tv_usec) * 1e-6;
 
 	printf("Berechnungszeit:    %f s\n", time);
+
+	if (options->bench[0] > 0)
+	{
+		printf("Benchmark:          %d Läufe nach %d Aufwärmläufen\n", options->bench[0], options->bench[1]);
+		printf("                    Median %f s, Mittel %f s, Standardabweichung %f s\n", results->bench[0], results->bench[1], results->bench[2]);
+		printf("                    95-%%-Konfidenzintervall des Mittels: %f .. %f s\n", results->bench[3], results->bench[4]);
+	}
+
 	printf("Speicherbedarf:     %f MiB\n", (N + 1) * (N + 1) * sizeof(double) * arguments->num_matrices / 1024.0 / 1024.0);
 	printf("Berechnungsmethode: ");
 
@@ -558,6 +881,14 @@ displayStatistics(struct calculation_arguments const* arguments, struct calculat
 	printf("\n");
 	printf("Anzahl Iterationen: %" PRIu64 "\n", results->stat_iteration);
 	printf("Norm des Fehlers:   %e\n", results->stat_precision);
+
+	// eine CSV-Zeile pro Konfiguration, z.B. grep '^bench,' über alle Läufe eines Jobskripts
+	if (options->bench[0] > 0)
+	{
+		printf("# bench,method,interlines,threads,tiling,iterations,reps,warmup,median_s,mean_s,stddev_s,ci95_low_s,ci95_high_s\n");
+		printf("bench,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%d,%d,%.6f,%.6f,%.6f,%.6f,%.6f\n", options->method, options->interlines, options->number, options->tiling, results->stat_iteration, options->bench[0], options->bench[1], results->bench[0], results->bench[1], results->bench[2], results->bench[3], results->bench[4]);
+	}
+
 	printf("\n");
 }
 
@@ -598,6 +929,68 @@ displayMatrix(struct calculation_arguments* arguments, struct calculation_result
 	fflush(stdout);
 }
 
+/* ************************************************************************ */
+/* compareTime: qsort order of the solve times                              */
+/* ************************************************************************ */
+static int
+compareTime(void const* a, void const* b)
+{
+	double const x = *(double const*)a;
+	double const y = *(double const*)b;
+
+	return (x > y) - (x < y);
+}
+
+/* ************************************************************************ */
+/* benchStatistics: median, mean and sample standard deviation of count     */
+/* solve times and the 95 % confidence interval of the mean (Student's t),  */
+/* sorts the times                                                          */
+/* ************************************************************************ */
+static void
+benchStatistics(double* times, int count, double* bench)
+{
+	static double const quantiles[BENCH_T] = {
+		12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+		 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+		 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+	};
+
+	double sum    = 0.0;
+	double square = 0.0;
+	double t      = 0.0;
+	int    i;
+
+	qsort(times, count, sizeof(times[0]), compareTime);
+
+	bench[0] = (count % 2 == 1) ? times[count / 2] : (times[count / 2 - 1] + times[count / 2]) / 2.0;
+
+	for (i = 0; i < count; i++)
+	{
+		sum += times[i];
+	}
+
+	bench[1] = sum / count;
+
+	for (i = 0; i < count; i++)
+	{
+		square += (times[i] - bench[1]) * (times[i] - bench[1]);
+	}
+
+	// bei einem Lauf gibt es keine Streuung und kein Intervall
+	if (count > 1)
+	{
+		bench[2] = sqrt(square / (count - 1));
+		t        = (count - 1 <= BENCH_T) ? quantiles[count - 2] : 1.96;
+	}
+	else
+	{
+		bench[2] = 0.0;
+	}
+
+	bench[3] = bench[1] - t * bench[2] / sqrt(count);
+	bench[4] = bench[1] + t * bench[2] / sqrt(count);
+}
+
 /* ************************************************************************ */
 /*  main                                                                    */
 /* ************************************************************************ */
@@ -613,11 +1006,37 @@ main(int argc, char** argv)
 	initVariables(&arguments, &results, &options);
 
 	allocateMatrices(&arguments);
-	initMatrices(&arguments, &options);
 
-	gettimeofday(&start_time, NULL);
-	calculate(&arguments, &results, &options);
-	gettimeofday(&comp_time, NULL);
+	/* mit --bench W + R Läufe auf denselben Matrizen, ausgegeben wird der letzte */
+	int const runs = options.bench[0] + ((options.bench[0] > 0) ? options.bench[1] : 1);
+	double* const times = allocateMemory(runs * sizeof(double));
+
+	for (int run = 0; run < runs; run++)
+	{
+		initResults(&results);
+		initMatrices(&arguments, &options);
+
+		gettimeofday(&start_time, NULL);
+		/* askParams only accepts tiling for Jacobi with a number of iterations */
+		if (options.tiling > 0)
+		{
+			calculate_tiled(&arguments, &results, &options);
+		}
+		else
+		{
+			calculate(&arguments, &results, &options);
+		}
+		gettimeofday(&comp_time, NULL);
+
+		times[run] = (comp_time.tv_sec - start_time.tv_sec) + (comp_time.tv_usec - start_time.tv_usec) * 1e-6;
+	}
+
+	if (options.bench[0] > 0)
+	{
+		benchStatistics(times + options.bench[1], options.bench[0], results.bench);
+	}
+
+	free(times);
 
 	displayStatistics(&arguments, &results, &options);
 	displayMatrix(&arguments, &results, &options);
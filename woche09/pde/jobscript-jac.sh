@@ -4,33 +4,30 @@
 
 make clean
 . /opt/spack/pp-2021.env.sh
-module load hyperfine
 make
-echo "warmup"
-hyperfine --warmup 3 'srun -p vl-parcio -n 1 -N 1 --mpi=pmi2 ./partdiff 1 2 1024 2 2 836'
 echo "Benchmark #1 (1,1,836)"
-hyperfine 'srun -p vl-parcio -n 1 -N 1 --mpi=pmi2 ./partdiff 1 2 1024 2 2 836'
+srun -p vl-parcio -n 1 -N 1 --mpi=pmi2 ./partdiff 1 2 1024 2 2 836 --bench=10,3
 
 echo "Benchmark #2 (1,2,1182)"
-hyperfine 'srun -p vl-parcio -n 2 -N 1 --mpi=pmi2 ./partdiff 1 2 1024 2 2 1182'
+srun -p vl-parcio -n 2 -N 1 --mpi=pmi2 ./partdiff 1 2 1024 2 2 1182 --bench=10,3
 
 echo "Benchmark #3 (1,3,1448)"
-hyperfine 'srun -p vl-parcio -n 3 -N 1 --mpi=pmi2 ./partdiff 1 2 1024 2 2 1448'
+srun -p vl-parcio -n 3 -N 1 --mpi=pmi2 ./partdiff 1 2 1024 2 2 1448 --bench=10,3
 
 echo "Benchmark #4 (1,6,2048)"
-hyperfine 'srun -p vl-parcio -n 6 -N 1 --mpi=pmi2 ./partdiff 1 2 1024 2 2 2048'
+srun -p vl-parcio -n 6 -N 1 --mpi=pmi2 ./partdiff 1 2 1024 2 2 2048 --bench=10,3
 
 echo "Benchmark #5 (1,12,2896)"
-hyperfine 'srun -p vl-parcio -n 12 -N 1 --mpi=pmi2 ./partdiff 1 2 1024 2 2 2896'
+srun -p vl-parcio -n 12 -N 1 --mpi=pmi2 ./partdiff 1 2 1024 2 2 2896 --bench=10,3
 
 echo "Benchmark #6 (1,24,4096)"
-hyperfine 'srun -p vl-parcio -n 24 -N 1 --mpi=pmi2 ./partdiff 1 2 1024 2 2 4096'
+srun -p vl-parcio -n 24 -N 1 --mpi=pmi2 ./partdiff 1 2 1024 2 2 4096 --bench=10,3
 
 echo "Benchmark #7 (2,48,5793)"
-hyperfine 'srun -p vl-parcio -n 48 -N 2 --mpi=pmi2 ./partdiff 1 2 1024 2 2 5793'
+srun -p vl-parcio -n 48 -N 2 --mpi=pmi2 ./partdiff 1 2 1024 2 2 5793 --bench=10,3
 
 echo "Benchmark #8 (4, 96, 8192)"
-hyperfine 'srun -p vl-parcio -n 96 -N 4 --mpi=pmi2 ./partdiff 1 2 1024 2 2 8192'
+srun -p vl-parcio -n 96 -N 4 --mpi=pmi2 ./partdiff 1 2 1024 2 2 8192 --bench=10,3
 
 echo "Benchmark #9 (8, 192, 11585)"
-hyperfine 'srun -p vl-parcio -n 192 -N 8 --mpi=pmi2 ./partdiff 1 2 1024 2 2 11585'
+srun -p vl-parcio -n 192 -N 8 --mpi=pmi2 ./partdiff 1 2 1024 2 2 11585 --bench=10,3
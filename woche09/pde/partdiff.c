@@ -23,7 +23,7 @@
 /* ************************************************************************ */
 /* Include standard header file.                                            */
 /* ************************************************************************ */
-#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -33,8 +33,16 @@
 #include <malloc.h>
 #include <string.h>
 #include <sys/time.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <time.h>
 #include <mpi.h>
+#include <omp.h>
+#include <sched.h>
 #include <stdbool.h>
+#include <stdatomic.h>
+#include <unistd.h>
 
 /* ************* */
 /* Some defines. */
@@ -49,10 +57,77 @@
 #define MAX_THREADS       1024
 #define METH_GAUSS_SEIDEL 1
 #define METH_JACOBI       2
+#define METH_CHEBYSHEV    3
+#define METH_CG           4
+#define METH_MULTIGRID    5
+#define METH_SCHWARZ      6
+
+/* Jacobi und Tschebyscheff rechnen mit denselben Sweeps auf zwei Matrizen */
+#define JACOBI_SWEEPS(method) ((method) == METH_JACOBI || (method) == METH_CHEBYSHEV)
 #define FUNC_F0           1
 #define FUNC_FPISIN       2
 #define TERM_PREC         1
 #define TERM_ITER         2
+#define MAX_LAG           16
+
+/* Richtungen der Nachbarn bei der 2D-Zerlegung, auch als Tags benutzt */
+#define DIR_UP            0
+#define DIR_DOWN          1
+#define DIR_LEFT          2
+#define DIR_RIGHT         3
+
+/* Verfahren für den Halo-Austausch der Streifen */
+#define HALO_ISEND        0
+#define HALO_PERSISTENT   1
+#define HALO_NEIGHBOR     2
+#define HALO_PUT          3
+
+/* Mehrgitter: höchstens so viele Stufen, Glättungsschritte vor und nach der
+ * Grobgitterkorrektur, eigene Zeilen pro Rang, unter denen gesammelt wird */
+#define MG_MAX_LEVELS     24
+#define MG_SMOOTH         2
+#define MG_MIN_ROWS       4
+
+/* Vorkonditionierer des CG-Verfahrens */
+#define PRECOND_JACOBI    0
+#define PRECOND_SSOR      1
+
+/* Phasen der Laufzeitmessung pro Rang, Sonstiges ist der Rest der Gesamtzeit */
+#define PHASE_COMPUTE     0
+#define PHASE_HALO        1
+#define PHASE_REDUCE      2
+#define PHASE_SYNC        3
+#define PHASE_OTHER       4
+#define PHASE_TOTAL       5
+#define PHASES            6
+
+/* Ereignisse der Zeitleiste (--trace), TRACE_NONE wird nicht aufgezeichnet */
+#define TRACE_NONE        (-1)
+#define TRACE_SWEEP       0
+#define TRACE_SEND        1
+#define TRACE_WAIT        2
+#define TRACE_REDUCE      3
+#define TRACE_SYNC        4
+#define TRACE_KINDS       5
+#define TRACE_EVENTS      65536
+#define TRACE_ROUNDS      16
+
+/* Hardwarezähler pro Thread, die FP-Zähler zählen skalare, 128-, 256- und
+ * 512-Bit-Instruktionen mit doppelter Genauigkeit (1, 2, 4, 8 Operationen) */
+#define COUNTER_CYCLES       0
+#define COUNTER_INSTRUCTIONS 1
+#define COUNTER_LLC_MISSES   2
+#define COUNTER_FP           3
+#define COUNTERS             7
+#define CACHE_LINE           64
+
+/* STREAM-Kalibrierung (--calibrate): Elemente pro Feld und Knoten (256 MiB),
+ * Wiederholungen, von denen die schnellste zählt */
+#define STREAM_ELEMENTS   (1 << 25)
+#define STREAM_REPS       10
+
+/* --bench: 97,5-%-Quantile der t-Verteilung bis zu so vielen Freiheitsgraden, darüber 1,96 */
+#define BENCH_T 30
 
 struct calculation_arguments
 {
@@ -65,6 +140,85 @@ struct calculation_arguments
     uint64_t ranks;
     int row_start;
     int row_end;
+
+    // zusätzliche Geisterzeilen oben/unten bei tiefen Halos (--depth)
+    int ghost[2];
+
+    // Spalten der lokalen Matrix, bei Streifen immer N + 1 ab Spalte 0
+    uint64_t cols;
+    int col_start;
+
+    // nur bei 2D-Zerlegung: kartesischer Kommunikator und Nachbarn
+    MPI_Comm comm;
+    int neighbours[4]; /* oben, unten, links, rechts (MPI_PROC_NULL am Rand) */
+
+    // nur bei Shared Memory: Fenster mit den Matrizen und den Iterationszählern der Ränge eines Knotens
+    MPI_Comm     node_comm;
+    MPI_Win      window;
+    MPI_Win      flag_window;
+    atomic_long* flag;           /* abgeschlossene Iterationen dieses Rangs */
+    double*      shared[2];      /* Matrizen des oberen/unteren Nachbarn (NULL: anderer Knoten) */
+    uint64_t     shared_ranks[2]; /* Zeilenzahl der Nachbarn */
+    atomic_long* shared_flag[2];
+};
+
+/* halo exchange of the strip decomposition (see haloInit) */
+struct halo
+{
+	int         method;
+	int         rank;
+	MPI_Comm    comm;
+	int         neighbours[2]; /* oben, unten (MPI_PROC_NULL am Rand und bei Shared Memory) */
+	int         matrix;        /* Matrix des laufenden Austauschs */
+	MPI_Request requests[2][4];
+	double      time;          /* Zeit in haloStart und haloWait */
+
+	// MPI_Ineighbor_alltoallv
+	MPI_Comm graph;
+	int      graph_neighbours[2];
+	int      counts[2];
+	int      sdispls[2];
+	int      rdispls[2];
+
+	// MPI_Put: Fenster über den Matrizen und Zähler der fertigen Iterationen der Nachbarn
+	MPI_Win  window;
+	MPI_Win  flag_window;
+	long*    flag;
+	MPI_Aint displacements[2][2];
+};
+
+/* node and socket of a rank (see placeRanks) */
+struct placement
+{
+	int node;
+	int socket;
+	int rank;
+};
+
+/* state of the lagged convergence check (see checkTermination) */
+struct convergence
+{
+	uint64_t    started; /* reductions started by this solver call */
+	MPI_Request reduction[MAX_LAG + 1];
+	double      local[MAX_LAG + 1];
+	double      global[MAX_LAG + 1];
+};
+
+/* one level of the multigrid hierarchy (see mgInit) */
+struct level
+{
+	int      N;         /* Abstände, also N + 1 Zeilen und Spalten */
+	int      active;    /* die ersten active Ränge haben Zeilen dieser Stufe */
+	bool     gathered;  /* auf weniger Ränge gesammelt als die feinere Stufe */
+	MPI_Comm comm;      /* die aktiven Ränge, MPI_COMM_NULL bei den anderen */
+	int*     starts;    /* erste Zeile jedes aktiven Rangs, starts[active] = N + 1 */
+	int      row_start; /* erste eigene Zeile */
+	int      rows;      /* eigene Zeilen, lokal 1 .. rows, 0 und rows + 1 sind Halos */
+	double*  v;         /* Lösung bzw. Korrektur */
+	double*  f;         /* rechte Seite */
+	double*  r;         /* Residuum */
+	double*  stage;     /* gathered: grobe Zeilen im Layout der feineren Stufe */
+	double*  work;      /* gröbste Stufe: Hilfsvektoren des CG, ungerades N: gewichtetes Residuum */
 };
 
 struct calculation_results
@@ -72,6 +226,57 @@ struct calculation_results
 	uint64_t m;
 	uint64_t stat_iteration; /* number of current iteration */
 	double   stat_precision; /* actual precision of all slaves in iteration */
+	double   halo_time[2];   /* Halo-Austausch pro Iteration, Mittel und Maximum der Ränge */
+	uint64_t stat_lagged;    /* iterations after the precision was reached */
+	double   sweep_time;     /* compute time of this rank without waiting (Jacobi strips) */
+	int      rebalances;     /* number of redistributions of the rows */
+	int      rows[2];        /* fewest and most rows of a rank after the last redistribution */
+	uint64_t async_sweeps[2]; /* fewest and most sweeps of a rank with --async */
+	int      levels;         /* multigrid levels */
+	int      level_ranks[MG_MAX_LEVELS]; /* active ranks per level */
+	double   phase_time[PHASES][3]; /* time per phase (PHASE_*), minimum, mean and maximum of the ranks */
+	double   bytes[3];       /* bytes sent per rank, minimum, mean and maximum */
+	double   imbalance;      /* maximum over mean of the work without communication, in percent */
+	double   counters[COUNTERS]; /* hardware counters of all threads and ranks */
+	int      counted[COUNTERS];  /* counter was available on every thread */
+	double   setup_time;     /* from before MPI_Init until the calculation starts, slowest rank */
+	double   memory[3];      /* matrices per rank, fewest and most bytes and sum of the ranks */
+	double   resident[2];    /* peak resident memory (VmHWM), most of a rank and sum of the ranks */
+	double   stream[2];      /* STREAM copy and triad of all nodes in GB/s, 0 without calibration */
+	int      halo_links[2];  /* neighbours of all ranks read through shared memory and reached by messages */
+	double   bench[5];       /* --bench: median, mean and standard deviation of the solve time, 95 % confidence interval */
+};
+
+/* phase timers of this rank, only updated by the master thread */
+struct profile
+{
+	double   phase[PHASES];
+	uint64_t bytes; /* Halo-Daten an andere Ränge gesendet */
+};
+
+/* one event of the timeline, times of wallTime on this rank */
+struct trace_event
+{
+	double begin;
+	double end;
+	int    kind; /* TRACE_* */
+};
+
+/* ring buffer of one thread, the oldest events are overwritten */
+struct trace_buffer
+{
+	uint64_t           count; /* recorded events, also the ones overwritten */
+	struct trace_event events[];
+};
+
+/* timeline of this rank (see traceInit) */
+struct trace
+{
+	int                   capacity; /* events per thread, 0: no trace */
+	int                   threads;
+	struct trace_buffer** buffers;
+	double                sync[2][2]; /* lokale Zeit und Abstand zu Rang 0 bei Start und Ende */
+	double                origin;     /* Start auf der Uhr von Rang 0 */
 };
 
 struct options
@@ -87,6 +292,59 @@ struct options
     // für Informationen über Ränge und Größe
     int rank;
     int size;
+
+    // alle Ränge in der Reihenfolge der Streifen (siehe placeRanks), rank bezieht sich hierauf
+    MPI_Comm comm;
+    bool     reorder;
+    int      crossings[2][2]; /* Nachbarpaare über Knoten/Sockel, vorher und nachher */
+
+    // Prozessgitter für die 2D-Zerlegung (0 x 0: Streifen)
+    int grid[2];
+
+    // Halo-Zeilen von Nachbarn auf demselben Knoten direkt lesen
+    bool shm;
+
+    // Verfahren für den Halo-Austausch (HALO_*)
+    int halo;
+
+    // Spaltenblöcke der Gauß-Seidel-Pipeline (0: automatisch)
+    int gs_blocks;
+
+    // Iterationen zwischen Residuum und Abbruchentscheidung bei TERM_PREC
+    int lag;
+
+    // Tiefe der Halos bei Jacobi mit Streifen, Austausch alle depth Iterationen
+    int depth;
+
+    // Punkte pro Richtung der Vorschau in partdiff_preview.dat (0: keine)
+    int preview;
+
+    // Lastverteilung: Iterationen bis zur ersten Umverteilung, danach Intervall (0: keine)
+    int balance[2];
+
+    // Schwarz: überlappende Zeilen pro Seite, Gauß-Seidel-Sweeps pro Austausch, SOR-Gewicht
+    int    overlap;
+    int    inner;
+    double sor;
+
+    // Kacheln pro Rang für Jacobi mit Streifen (0: eine Kachel ohne Scheduler)
+    int tiles;
+
+    // Jacobi ohne Gleichschritt, Halos über einseitige Kommunikation
+    bool async;
+
+    // Vorkonditionierer des CG-Verfahrens (PRECOND_*) und Gewicht bei SSOR
+    int    precond;
+    double ssor_omega;
+
+    // Ereignisse pro Thread in der Zeitleiste partdiff_trace.json (0: keine)
+    int trace;
+
+    // Speicherbandbreite der Knoten messen und in partdiff_stream.dat ablegen
+    bool calibrate;
+
+    // gemessene Läufe und Aufwärmläufe der Berechnung im selben Prozess (0: einmal rechnen)
+    int bench[2];
 };
 
 /* ************************************************************************ */
@@ -96,16 +354,24 @@ struct options
 /* time measurement variables */
 struct timeval start_time; /* time when program started */
 struct timeval comp_time;  /* time when calculation completed */
+struct profile  profile;    /* phases of the calculation on this rank */
+struct trace    trace;      /* timeline of this rank with --trace */
+int           (*counter_fds)[COUNTERS]; /* perf_event_open of every thread, -1 if unavailable */
 
 static void
 usage(char* name)
 {
-	printf("Usage: %s [num] [method] [lines] [func] [term] [prec/iter]\n", name);
+	printf("Usage: %s [num] [method] [lines] [func] [term] [prec/iter] [options]\n", name);
 	printf("\n");
-	printf("  - num:       number of threads (1 .. %d)\n", MAX_THREADS);
-	printf("  - method:    calculation method (1 .. 2)\n");
+	printf("  - num:       number of OpenMP threads per MPI rank (1 .. %d)\n", MAX_THREADS);
+	printf("                 used by the Jacobi, CG and multigrid solvers with strips, otherwise ignored\n");
+	printf("  - method:    calculation method (1 .. 6)\n");
 	printf("                 %1d: Gauß-Seidel\n", METH_GAUSS_SEIDEL);
 	printf("                 %1d: Jacobi\n", METH_JACOBI);
+	printf("                 %1d: Jacobi mit Tschebyscheff-Beschleunigung\n", METH_CHEBYSHEV);
+	printf("                 %1d: vorkonditioniertes CG (pipelined)\n", METH_CG);
+	printf("                 %1d: Mehrgitter (V-Zyklen)\n", METH_MULTIGRID);
+	printf("                 %1d: additives Schwarz mit Gauß-Seidel pro Rang\n", METH_SCHWARZ);
 	printf("  - lines:     number of interlines (0 .. %d)\n", MAX_INTERLINES);
 	printf("                 matrixsize = (interlines * 8) + 9\n");
 	printf("  - func:      interference function (1 .. 2)\n");
@@ -117,6 +383,40 @@ usage(char* name)
 	printf("  - prec/iter: depending on term:\n");
 	printf("                 precision:  1e-4 .. 1e-20\n");
 	printf("                 iterations:    1 .. %d\n", MAX_ITERATION);
+	printf("  - options:\n");
+	printf("                 --grid:       2D decomposition (Jacobi only), grid from MPI_Dims_create\n");
+	printf("                 --grid=PxQ:   2D decomposition with P process rows and Q process columns\n");
+	printf("                 --no-shm:     exchange halos with messages also between ranks on the same node\n");
+	printf("                 --no-reorder: keep the rank order of MPI_COMM_WORLD for the strips\n");
+	printf("                 --gs-blocks=K: column blocks of the Gauß-Seidel pipeline (default: 4 per rank)\n");
+	printf("                 --lag=D:      check the precision D iterations later (1 .. %d, default: 1)\n", MAX_LAG);
+	printf("                 --depth=K:    K halo rows per side, exchanged every K iterations (Jacobi strips)\n");
+	printf("                 --preview=S:  write S x S sampled values to partdiff_preview.dat (2 .. lines)\n");
+	printf("                 --balance=W[,R]: measure W iterations, then redistribute the rows by\n");
+	printf("                               throughput, again every R iterations (Jacobi strips)\n");
+	printf("                 --overlap=K:  overlapping rows per side of Schwarz (default: 1)\n");
+	printf("                 --inner=S:    Gauß-Seidel sweeps of Schwarz per exchange (default: 4)\n");
+	printf("                 --sor=W:      SOR weight of these sweeps (0 .. 2, default: 1)\n");
+	printf("                 --tiles=T:    T tiles per rank (at most one per row) for the Jacobi strips,\n");
+	printf("                               run by a task scheduler\n");
+	printf("                 --async:      Jacobi strips without lockstep, halos via MPI_Accumulate\n");
+	printf("                 --calibrate:  measure the memory bandwidth of the nodes (STREAM copy/triad with\n");
+	printf("                               these ranks and threads) and add it to partdiff_stream.dat,\n");
+	printf("                               later runs report their bandwidth against it\n");
+	printf("                 --bench=R[,W]: solve W + R times in one process (default W: 1) and report\n");
+	printf("                               median, mean, standard deviation and 95 %% confidence interval\n");
+	printf("                               of the last R solve times (slowest rank), plus a CSV row\n");
+	printf("                 --trace[=E]:  write a timeline of sweeps, halo exchanges and reductions to\n");
+	printf("                               partdiff_trace.json (Chrome trace format), keeping the last\n");
+	printf("                               E events per thread (default: %d)\n", TRACE_EVENTS);
+	printf("                 --precond=P:  preconditioner of CG (default: jacobi)\n");
+	printf("                                 jacobi:     diagonal, i.e. plain CG for this operator\n");
+	printf("                                 ssor[,W]:   symmetric SOR per rank with weight W (0 .. 2, default: 1)\n");
+	printf("                 --halo=TYPE:  halo exchange of the Jacobi and CG strips (default: isend)\n");
+	printf("                                 isend:      MPI_Isend/MPI_Irecv\n");
+	printf("                                 persistent: MPI_Send_init/MPI_Recv_init and MPI_Startall\n");
+	printf("                                 neighbor:   MPI_Ineighbor_alltoallv on a graph communicator\n");
+	printf("                                 put:        MPI_Put with passive target synchronization\n");
 	printf("\n");
 	printf("Example: %s 1 2 100 1 2 100 \n", name);
 }
@@ -142,7 +442,7 @@ askParams(struct options* options, int argc, char** argv)
 
 	ret = sscanf(argv[2], "%" SCNu64, &(options->method));
 
-	if (ret != 1 || !(options->method == METH_GAUSS_SEIDEL || options->method == METH_JACOBI))
+	if (ret != 1 || !(options->method == METH_GAUSS_SEIDEL || JACOBI_SWEEPS(options->method) || options->method == METH_CG || options->method == METH_MULTIGRID || options->method == METH_SCHWARZ))
 	{
 		usage(argv[0]);
 		exit(1);
@@ -196,6 +496,398 @@ askParams(struct options* options, int argc, char** argv)
 			exit(1);
 		}
 	}
+
+	options->grid[0] = 0;
+	options->grid[1] = 0;
+	options->shm     = true;
+	options->reorder = true;
+	options->halo    = HALO_ISEND;
+	options->gs_blocks = 0;
+	options->lag       = 1;
+	options->depth     = 1;
+	options->preview   = 0;
+	options->balance[0] = 0;
+	options->balance[1] = 0;
+	options->precond    = PRECOND_JACOBI;
+	options->async      = false;
+	options->tiles      = 0;
+	options->overlap    = 1;
+	options->inner      = 4;
+	options->sor        = 1.0;
+	options->ssor_omega = 1.0;
+	options->trace      = 0;
+	options->calibrate  = false;
+	options->bench[0]   = 0;
+	options->bench[1]   = 1;
+
+	/* optionale Argumente nach den festen Parametern */
+	for (int i = 7; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--grid") == 0)
+		{
+			/* MPI_Dims_create wählt das Gitter */
+			options->grid[0] = -1;
+			options->grid[1] = -1;
+		}
+		else if (strcmp(argv[i], "--no-shm") == 0)
+		{
+			options->shm = false;
+		}
+		else if (strcmp(argv[i], "--no-reorder") == 0)
+		{
+			options->reorder = false;
+		}
+		else if (strcmp(argv[i], "--halo=isend") == 0)
+		{
+			options->halo = HALO_ISEND;
+		}
+		else if (strcmp(argv[i], "--halo=persistent") == 0)
+		{
+			options->halo = HALO_PERSISTENT;
+		}
+		else if (strcmp(argv[i], "--halo=neighbor") == 0)
+		{
+			options->halo = HALO_NEIGHBOR;
+		}
+		else if (strcmp(argv[i], "--halo=put") == 0)
+		{
+			options->halo = HALO_PUT;
+		}
+		else if (strncmp(argv[i], "--overlap=", 10) == 0)
+		{
+			ret = sscanf(argv[i] + 10, "%d", &(options->overlap));
+
+			if (ret != 1 || options->overlap < 0)
+			{
+				usage(argv[0]);
+				exit(1);
+			}
+		}
+		else if (strncmp(argv[i], "--inner=", 8) == 0)
+		{
+			ret = sscanf(argv[i] + 8, "%d", &(options->inner));
+
+			if (ret != 1 || options->inner < 1)
+			{
+				usage(argv[0]);
+				exit(1);
+			}
+		}
+		else if (strncmp(argv[i], "--sor=", 6) == 0)
+		{
+			ret = sscanf(argv[i] + 6, "%lf", &(options->sor));
+
+			if (ret != 1 || !(options->sor > 0.0 && options->sor < 2.0))
+			{
+				usage(argv[0]);
+				exit(1);
+			}
+		}
+		else if (strncmp(argv[i], "--tiles=", 8) == 0)
+		{
+			ret = sscanf(argv[i] + 8, "%d", &(options->tiles));
+
+			if (ret != 1 || options->tiles < 1)
+			{
+				usage(argv[0]);
+				exit(1);
+			}
+		}
+		else if (strcmp(argv[i], "--async") == 0)
+		{
+			options->async = true;
+		}
+		else if (strcmp(argv[i], "--calibrate") == 0)
+		{
+			options->calibrate = true;
+		}
+		else if (strcmp(argv[i], "--trace") == 0)
+		{
+			options->trace = TRACE_EVENTS;
+		}
+		else if (strncmp(argv[i], "--trace=", 8) == 0)
+		{
+			ret = sscanf(argv[i] + 8, "%d", &(options->trace));
+
+			if (ret != 1 || options->trace < 1)
+			{
+				usage(argv[0]);
+				exit(1);
+			}
+		}
+		else if (strcmp(argv[i], "--precond=jacobi") == 0)
+		{
+			options->precond = PRECOND_JACOBI;
+		}
+		else if (strncmp(argv[i], "--precond=ssor", 14) == 0)
+		{
+			options->precond = PRECOND_SSOR;
+
+			if (argv[i][14] != '\0' && (sscanf(argv[i] + 14, ",%lf", &(options->ssor_omega)) != 1 || !(options->ssor_omega > 0.0 && options->ssor_omega < 2.0)))
+			{
+				usage(argv[0]);
+				exit(1);
+			}
+		}
+		else if (strncmp(argv[i], "--balance=", 10) == 0)
+		{
+			ret = sscanf(argv[i] + 10, "%d,%d", &(options->balance[0]), &(options->balance[1]));
+
+			if (ret < 1 || options->balance[0] < 1 || options->balance[1] < 0)
+			{
+				usage(argv[0]);
+				exit(1);
+			}
+		}
+		else if (strncmp(argv[i], "--bench=", 8) == 0)
+		{
+			ret = sscanf(argv[i] + 8, "%d,%d", &(options->bench[0]), &(options->bench[1]));
+
+			if (ret < 1 || options->bench[0] < 1 || options->bench[1] < 0)
+			{
+				usage(argv[0]);
+				exit(1);
+			}
+		}
+		else if (strncmp(argv[i], "--preview=", 10) == 0)
+		{
+			ret = sscanf(argv[i] + 10, "%d", &(options->preview));
+
+			if (ret != 1 || options->preview < 2 || (uint64_t)options->preview > options->interlines * 8 + 9)
+			{
+				usage(argv[0]);
+				exit(1);
+			}
+		}
+		else if (strncmp(argv[i], "--depth=", 8) == 0)
+		{
+			ret = sscanf(argv[i] + 8, "%d", &(options->depth));
+
+			if (ret != 1 || options->depth < 1)
+			{
+				usage(argv[0]);
+				exit(1);
+			}
+		}
+		else if (strncmp(argv[i], "--lag=", 6) == 0)
+		{
+			ret = sscanf(argv[i] + 6, "%d", &(options->lag));
+
+			if (ret != 1 || options->lag < 1 || options->lag > MAX_LAG)
+			{
+				usage(argv[0]);
+				exit(1);
+			}
+		}
+		else if (strncmp(argv[i], "--gs-blocks=", 12) == 0)
+		{
+			ret = sscanf(argv[i] + 12, "%d", &(options->gs_blocks));
+
+			if (ret != 1 || options->gs_blocks < 1)
+			{
+				usage(argv[0]);
+				exit(1);
+			}
+		}
+		else if (strncmp(argv[i], "--grid=", 7) == 0)
+		{
+			ret = sscanf(argv[i] + 7, "%dx%d", &(options->grid[0]), &(options->grid[1]));
+
+			if (ret != 2 || options->grid[0] < 1 || options->grid[1] < 1 || options->grid[0] * options->grid[1] != options->size)
+			{
+				usage(argv[0]);
+				exit(1);
+			}
+		}
+		else
+		{
+			usage(argv[0]);
+			exit(1);
+		}
+	}
+
+	/* 2D-Zerlegung nur für Jacobi (auch mit Tschebyscheff) */
+	if (options->grid[0] != 0 && !JACOBI_SWEEPS(options->method))
+	{
+		usage(argv[0]);
+		exit(1);
+	}
+
+	/* Halo-Verfahren für Jacobi und CG mit Streifen */
+	if (options->halo != HALO_ISEND && !(JACOBI_SWEEPS(options->method) || options->method == METH_CG))
+	{
+		usage(argv[0]);
+		exit(1);
+	}
+
+	if (options->grid[0] != 0 && options->halo != HALO_ISEND)
+	{
+		usage(argv[0]);
+		exit(1);
+	}
+
+	/* tiefe Halos nur für Jacobi mit Streifen und eigenem Austausch,
+	 * Tschebyscheff bräuchte dort zusätzlich die vorletzte Iterierte */
+	if (options->depth > 1 && (options->method != METH_JACOBI || options->grid[0] != 0 || options->halo != HALO_ISEND))
+	{
+		usage(argv[0]);
+		exit(1);
+	}
+
+	/* Lastverteilung nur für Jacobi mit Streifen und einer Halo-Zeile,
+	 * beim Umverteilen wandert nur die aktuelle Iterierte mit */
+	if (options->balance[0] > 0 && (options->method != METH_JACOBI || options->grid[0] != 0 || options->depth > 1))
+	{
+		usage(argv[0]);
+		exit(1);
+	}
+
+	/* Wiederholungen nur mit fester Verteilung, die Lastverteilung verschiebt die Zeilen */
+	if (options->bench[0] > 0 && options->balance[0] > 0)
+	{
+		usage(argv[0]);
+		exit(1);
+	}
+
+	/* asynchron nur für Jacobi mit Streifen und eigenem Austausch über Fenster */
+	if (options->async && (options->method != METH_JACOBI || options->grid[0] != 0 || options->halo != HALO_ISEND || options->depth > 1 || options->balance[0] > 0))
+	{
+		usage(argv[0]);
+		exit(1);
+	}
+
+	/* Kacheln nur für Jacobi mit Streifen und eigenem Austausch */
+	if (options->tiles > 0 && (!JACOBI_SWEEPS(options->method) || options->grid[0] != 0 || options->halo != HALO_ISEND || options->depth > 1 || options->balance[0] > 0 || options->async))
+	{
+		usage(argv[0]);
+		exit(1);
+	}
+
+	/* Shared Memory gibt es nur für Jacobi mit Streifen */
+	if (options->grid[0] != 0 || !JACOBI_SWEEPS(options->method) || options->depth > 1 || options->async || options->tiles > 0)
+	{
+		options->shm = false;
+	}
+}
+
+/* ************************************************************************ */
+/* distribute: splits count items into parts nearly equal blocks            */
+/* ************************************************************************ */
+static void
+distribute(int count, int parts, int index, int* start, int* length)
+{
+	int const rest = count % parts;
+
+	*length = count / parts + ((index < rest) ? 1 : 0);
+	*start  = index * (count / parts) + ((index < rest) ? index : rest);
+}
+
+/* ************************************************************************ */
+/* initCartesian: 2D decomposition of the inner points on a process grid    */
+/*                                                                          */
+/* Every rank stores its block of inner points plus one halo row/column on  */
+/* each side. At the border of the matrix the halo is the fixed boundary.   */
+/* ************************************************************************ */
+static void
+initCartesian(struct calculation_arguments* arguments, struct options const* options)
+{
+	int dims[2]    = { options->grid[0], options->grid[1] };
+	int periods[2] = { 0, 0 };
+	int coords[2];
+	int rank;
+	int start, length;
+
+	int const inner = arguments->N - 1;
+
+	if (dims[0] < 0)
+	{
+		dims[0] = 0;
+		dims[1] = 0;
+		MPI_Dims_create(options->size, 2, dims);
+	}
+
+	if (dims[0] > inner || dims[1] > inner)
+	{
+		if (options->rank == 0)
+		{
+			printf("Prozessgitter %dx%d ist zu groß für %d innere Zeilen\n", dims[0], dims[1], inner);
+		}
+
+		MPI_Finalize();
+		exit(1);
+	}
+
+	// reorder erlaubt MPI, die Ränge passend zur Hardware anzuordnen
+	MPI_Cart_create(options->comm, 2, dims, periods, 1, &(arguments->comm));
+	MPI_Comm_rank(arguments->comm, &rank);
+	MPI_Cart_coords(arguments->comm, rank, 2, coords);
+
+	MPI_Cart_shift(arguments->comm, 0, 1, &(arguments->neighbours[DIR_UP]), &(arguments->neighbours[DIR_DOWN]));
+	MPI_Cart_shift(arguments->comm, 1, 1, &(arguments->neighbours[DIR_LEFT]), &(arguments->neighbours[DIR_RIGHT]));
+
+	// innere Zeilen 1 .. N - 1 auf die Prozesszeilen verteilen
+	distribute(inner, dims[0], coords[0], &start, &length);
+	arguments->row_start = start;
+	arguments->row_end   = start + length + 1;
+	arguments->ranks     = length + 2;
+
+	// innere Spalten 1 .. N - 1 auf die Prozessspalten verteilen
+	distribute(inner, dims[1], coords[1], &start, &length);
+	arguments->col_start = start;
+	arguments->cols      = length + 2;
+}
+
+/* ************************************************************************ */
+/* initDeepHalo: widens the strip by depth - 1 ghost rows on every side     */
+/*               that has a neighbour (also the overlap of Schwarz)         */
+/*                                                                          */
+/* A rank sends its first/last depth own rows, so every rank needs at least */
+/* depth own rows.                                                          */
+/* ************************************************************************ */
+static void
+initDeepHalo(struct calculation_arguments* arguments, struct options const* options, int depth)
+{
+	int const own = arguments->ranks - 2;
+	int       fewest;
+
+	MPI_Allreduce(&own, &fewest, 1, MPI_INT, MPI_MIN, options->comm);
+
+	if (fewest < depth)
+	{
+		if (options->rank == 0)
+		{
+			printf("Halotiefe %d ist zu groß, ein Rang hat nur %d Zeilen\n", depth, fewest);
+		}
+
+		MPI_Finalize();
+		exit(1);
+	}
+
+	arguments->ghost[0] = (options->rank > 0) ? depth - 1 : 0;
+	arguments->ghost[1] = (options->rank < options->size - 1) ? depth - 1 : 0;
+
+	arguments->row_start -= arguments->ghost[0];
+	arguments->row_end   += arguments->ghost[1];
+	arguments->ranks     += arguments->ghost[0] + arguments->ghost[1];
+}
+
+/* ************************************************************************ */
+/* initResults: resets the results before every calculation                 */
+/* ************************************************************************ */
+static void
+initResults(struct calculation_results* results)
+{
+	results->m              = 0;
+	results->stat_iteration = 0;
+	results->stat_precision = 0;
+	results->halo_time[0]   = 0;
+	results->halo_time[1]   = 0;
+	results->stat_lagged    = 0;
+	results->sweep_time     = 0;
+	results->rebalances     = 0;
+	results->levels         = 0;
+	results->async_sweeps[0] = 0;
+	results->async_sweeps[1] = 0;
 }
 
 /* ************************************************************************ */
@@ -205,12 +897,10 @@ static void
 initVariables(struct calculation_arguments* arguments, struct calculation_results* results, struct options const* options)
 {
 	arguments->N            = (options->interlines * 8) + 9 - 1;
-	arguments->num_matrices = (options->method == METH_JACOBI) ? 2 : 1;
+	arguments->num_matrices = JACOBI_SWEEPS(options->method) ? 2 : 1;
 	arguments->h            = 1.0 / arguments->N;
 
-	results->m              = 0;
-	results->stat_iteration = 0;
-	results->stat_precision = 0;
+	initResults(results);
 
     // Berechnung wie viele Zeilen welcher Rang berechnet
     int rest = (arguments->N+1) % options->size;
@@ -249,6 +939,23 @@ initVariables(struct calculation_arguments* arguments, struct calculation_result
         arguments->ranks++;
     }
     // printf("Initialisiert für %d\n",options->rank);
+
+    arguments->cols = arguments->N + 1;
+    arguments->col_start = 0;
+    arguments->comm = options->comm;
+
+    arguments->ghost[0] = 0;
+    arguments->ghost[1] = 0;
+
+    if (options->depth > 1) {
+        initDeepHalo(arguments, options, options->depth);
+    } else if (options->method == METH_SCHWARZ && options->overlap > 0) {
+        initDeepHalo(arguments, options, options->overlap + 1);
+    }
+
+    if (options->grid[0] != 0) {
+        initCartesian(arguments, options);
+    }
 }
 
 /* ************************************************************************ */
@@ -257,6 +964,16 @@ initVariables(struct calculation_arguments* arguments, struct calculation_result
 static void
 freeMatrices(struct calculation_arguments* arguments)
 {
+	if (arguments->window != MPI_WIN_NULL)
+	{
+		MPI_Win_unlock_all(arguments->flag_window);
+		MPI_Win_unlock_all(arguments->window);
+		MPI_Win_free(&arguments->flag_window);
+		MPI_Win_free(&arguments->window);
+		MPI_Comm_free(&arguments->node_comm);
+		return;
+	}
+
 	free(arguments->M);
 }
 
@@ -279,25 +996,168 @@ allocateMemory(size_t size)
 }
 
 /* ************************************************************************ */
-/* allocateMatrices: allocates memory for matrices                          */
+/* allocateSharedMatrices: allocates the matrices in a shared memory window */
+/*                                                                          */
+/* All ranks of a node allocate their strip with MPI_Win_allocate_shared.   */
+/* For neighbours on the same node the solver then reads their boundary     */
+/* rows directly instead of receiving a copy. Every rank publishes the      */
+/* number of finished iterations in a second window, so neighbours know     */
+/* when a row is ready and when it may be overwritten.                      */
 /* ************************************************************************ */
 static void
-allocateMatrices(struct calculation_arguments* arguments)
+allocateSharedMatrices(struct calculation_arguments* arguments, struct options const* options)
 {
-	uint64_t const N = arguments->N;
+	MPI_Info  info;
+	MPI_Group strip_group, node_group;
+	MPI_Aint  size;
+	int       disp_unit;
+	int       node_size;
+	int       side;
 
-    // nur so viel reservieren wie notwendig
-	arguments->M = allocateMemory(arguments->num_matrices * arguments->ranks * (N + 1) * sizeof(double));
-}
+	uint64_t const row_size = arguments->N + 1;
 
-/* ************************************************************************ */
-/* initMatrices: Initialize matrix/matrices and some global variables       */
-/* ************************************************************************ */
-static void
-initMatrices(struct calculation_arguments* arguments, struct options const* options)
-{
-	uint64_t g, i, j; /* local variables for loops */
-	// printf("Beginne Matrix Initialisierung %d\n", options->rank);
+	int const neighbours[2] = {
+		options->rank > 0 ? options->rank - 1 : MPI_PROC_NULL,
+		options->rank < options->size - 1 ? options->rank + 1 : MPI_PROC_NULL,
+	};
+	int       node_neighbours[2];
+
+	MPI_Comm_split_type(options->comm, MPI_COMM_TYPE_SHARED, options->rank, MPI_INFO_NULL, &arguments->node_comm);
+
+	// jeder Rang bekommt eigene Seiten, damit sein Streifen in seinem NUMA-Knoten liegt
+	MPI_Info_create(&info);
+	MPI_Info_set(info, "alloc_shared_noncontig", "true");
+
+	MPI_Win_allocate_shared(arguments->num_matrices * arguments->ranks * row_size * sizeof(double), sizeof(double), info, arguments->node_comm, &arguments->M, &arguments->window);
+	MPI_Win_allocate_shared(sizeof(atomic_long), sizeof(atomic_long), info, arguments->node_comm, &arguments->flag, &arguments->flag_window);
+
+	MPI_Info_free(&info);
+
+	atomic_init(arguments->flag, 0);
+
+	// Nachbarn im Knoten-Kommunikator suchen
+	MPI_Comm_group(options->comm, &strip_group);
+	MPI_Comm_group(arguments->node_comm, &node_group);
+	MPI_Group_translate_ranks(strip_group, 2, neighbours, node_group, node_neighbours);
+	MPI_Group_free(&strip_group);
+	MPI_Group_free(&node_group);
+
+	// die Fenstergröße ist auf Seiten aufgerundet, deshalb die Zeilenzahlen austauschen
+	MPI_Comm_size(arguments->node_comm, &node_size);
+
+	uint64_t node_ranks[node_size];
+
+	MPI_Allgather(&arguments->ranks, 1, MPI_UINT64_T, node_ranks, 1, MPI_UINT64_T, arguments->node_comm);
+
+	for (side = 0; side < 2; side++)
+	{
+		arguments->shared[side]       = NULL;
+		arguments->shared_ranks[side] = 0;
+		arguments->shared_flag[side]  = NULL;
+
+		if (node_neighbours[side] == MPI_PROC_NULL || node_neighbours[side] == MPI_UNDEFINED)
+		{
+			continue;
+		}
+
+		MPI_Win_shared_query(arguments->window, node_neighbours[side], &size, &disp_unit, &arguments->shared[side]);
+		arguments->shared_ranks[side] = node_ranks[node_neighbours[side]];
+
+		MPI_Win_shared_query(arguments->flag_window, node_neighbours[side], &size, &disp_unit, &arguments->shared_flag[side]);
+	}
+
+	// passive Synchronisation für die ganze Laufzeit, Zugriffe werden mit MPI_Win_sync geordnet
+	MPI_Win_lock_all(MPI_MODE_NOCHECK, arguments->window);
+	MPI_Win_lock_all(MPI_MODE_NOCHECK, arguments->flag_window);
+
+	// alle Zähler sind initialisiert, bevor jemand sie liest
+	MPI_Barrier(arguments->node_comm);
+}
+
+/* ************************************************************************ */
+/* allocateMatrices: allocates memory for matrices                          */
+/* ************************************************************************ */
+static void
+allocateMatrices(struct calculation_arguments* arguments, struct options const* options)
+{
+	arguments->window    = MPI_WIN_NULL;
+	arguments->shared[0] = NULL;
+	arguments->shared[1] = NULL;
+	arguments->shared_flag[0] = NULL;
+	arguments->shared_flag[1] = NULL;
+
+	if (options->shm)
+	{
+		allocateSharedMatrices(arguments, options);
+		return;
+	}
+
+    // nur so viel reservieren wie notwendig
+	arguments->M = allocateMemory(arguments->num_matrices * arguments->ranks * arguments->cols * sizeof(double));
+}
+
+/* ************************************************************************ */
+/* initMatricesCartesian: Initialize the local blocks of the 2D composition */
+/* ************************************************************************ */
+static void
+initMatricesCartesian(struct calculation_arguments* arguments, struct options const* options)
+{
+	uint64_t g, i, j; /* local variables for loops */
+
+	uint64_t const N     = arguments->N;
+	uint64_t const ranks = arguments->ranks;
+	uint64_t const cols  = arguments->cols;
+	double const   h     = arguments->h;
+
+	typedef double(*matrix)[ranks][cols];
+
+	matrix Matrix = (matrix)arguments->M;
+
+	for (g = 0; g < arguments->num_matrices; g++)
+	{
+		for (i = 0; i < ranks; i++)
+		{
+			for (j = 0; j < cols; j++)
+			{
+				/* globale Position des Punktes */
+				uint64_t const gi = i + arguments->row_start;
+				uint64_t const gj = j + arguments->col_start;
+
+				Matrix[g][i][j] = 0.0;
+
+				/* initialize borders, depending on function (function 2: nothing to do) */
+				if (options->inf_func != FUNC_F0 || (gi == N && gj == 0) || (gi == 0 && gj == N))
+				{
+					continue;
+				}
+
+				if (gj == 0 || gi == 0)
+				{
+					Matrix[g][i][j] = 1.0 - (h * (gi + gj));
+				}
+				else if (gj == N || gi == N)
+				{
+					Matrix[g][i][j] = h * ((gj == N) ? gi : gj);
+				}
+			}
+		}
+	}
+}
+
+/* ************************************************************************ */
+/* initMatrices: Initialize matrix/matrices and some global variables       */
+/* ************************************************************************ */
+static void
+initMatrices(struct calculation_arguments* arguments, struct options const* options)
+{
+	if (options->grid[0] != 0)
+	{
+		initMatricesCartesian(arguments, options);
+		return;
+	}
+
+	uint64_t g, i, j; /* local variables for loops */
+	// printf("Beginne Matrix Initialisierung %d\n", options->rank);
 	uint64_t const N = arguments->N;
     uint64_t const ranks = arguments->ranks;
 	double const   h = arguments->h;
@@ -355,519 +1215,4420 @@ initMatrices(struct calculation_arguments* arguments, struct options const* opti
 }
 
 /* ************************************************************************ */
-/* calculate: solves the equation for Jacobi                                */
+/* fpisinRow: part of the inference function for local row i                */
 /* ************************************************************************ */
-static void
-MPI_jacobi_calculate(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
+static double
+fpisinRow(struct calculation_arguments const* arguments, struct options const* options, double fpisin, double pih, int i)
 {
-    // für nachfolgendes hin- und herreichen der Zeilen zwischen den Ränken
-    MPI_Request upper[2];
-    MPI_Request lower[2];
+	if (options->inf_func != FUNC_FPISIN)
+	{
+		return 0.0;
+	}
 
-	int    i, j;        /* local variables for loops */
-	int    m1, m2;      /* used as indices for old and new matrices */
-	double star;        /* four times center value minus 4 neigh.b values */
-	double residuum;    /* residuum of current iteration */
-	double maxresiduum; /* maximum residuum value of a slave in iteration */
+	/* Index der Startzeile zu i addieren */
+	return fpisin * sin(pih * (double)(i + arguments->row_start));
+}
 
-	int const    N = arguments->N;
-    int const ranks = arguments->ranks;
-	double const h = arguments->h;
+/* ************************************************************************ */
+/* jacobiRow: computes columns first .. last - 1 of one row of the Jacobi  */
+/* iteration, col_start is the global index of local column 0               */
+/* omega != 1 mixes in the previous iterate, which is still stored in out   */
+/* (Chebyshev acceleration); the residuum is always the plain Jacobi one    */
+/* returns the maximum of maxresiduum and the residua of the row            */
+/* ************************************************************************ */
+static double
+jacobiRow(double* restrict out, double const* up, double const* row, double const* down, int first, int last, int col_start, double fpisin_i, double pih, double omega, bool residual, double maxresiduum)
+{
+	int    j;
+	double star;
+	double residuum;
 
-	double pih    = 0.0;
-	double fpisin = 0.0;
+	/* over all columns */
+	for (j = first; j < last; j++)
+	{
+		star = 0.25 * (up[j] + row[j - 1] + row[j + 1] + down[j]);
 
-	int term_iteration = options->term_iteration;
+		if (fpisin_i != 0.0)
+		{
+			star += fpisin_i * sin(pih * (double)(j + col_start));
+		}
 
-	typedef double(*matrix)[ranks][N + 1];
+		if (residual)
+		{
+			residuum    = row[j] - star;
+			residuum    = fabs(residuum);
+			maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+		}
 
-	matrix Matrix = (matrix)arguments->M;
+		if (omega != 1.0)
+		{
+			star = omega * star + (1.0 - omega) * out[j];
+		}
 
-	/* initialize m1 and m2 depending on algorithm */
-	if (options->method == METH_JACOBI)
-	{
-		m1 = 0;
-		m2 = 1;
+		out[j] = star;
 	}
-	else
+
+	return maxresiduum;
+}
+
+/* ************************************************************************ */
+/* chebyshevOmega: weight of the next sweep of the Chebyshev semi-iteration */
+/*                                                                          */
+/* rho = cos(pi h) is the spectral radius of the Jacobi iteration matrix.   */
+/* With k sweeps done in this run, omega_0 = 1, omega_1 = 1 / (1 - rho²/2)  */
+/* and omega_k = 1 / (1 - rho² omega_{k-1} / 4). The recurrence needs no    */
+/* inner products, so there is no extra global reduction per sweep.         */
+/* Plain Jacobi always uses omega = 1.                                      */
+/* ************************************************************************ */
+static double
+chebyshevOmega(struct options const* options, double rho, double omega, uint64_t k)
+{
+	if (options->method != METH_CHEBYSHEV || k == 0)
 	{
-		m1 = 0;
-		m2 = 0;
+		return 1.0;
 	}
 
-	if (options->inf_func == FUNC_FPISIN)
+	if (k == 1)
 	{
-		pih    = M_PI * h;
-		fpisin = 0.25 * (2 * M_PI * M_PI) * h * h;
+		return 1.0 / (1.0 - 0.5 * rho * rho);
 	}
-	// printf("Step 0 %d\n", options->rank);
-	while (term_iteration > 0)
+
+	return 1.0 / (1.0 - 0.25 * rho * rho * omega);
+}
+
+/* ************************************************************************ */
+/* wallTime: monotonic clock for the phase timers                           */
+/* ************************************************************************ */
+static double
+wallTime(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+/* ************************************************************************ */
+/* traceEnd: records an event of the calling thread from begin until now,   */
+/*           returns the current time                                       */
+/* ************************************************************************ */
+static double
+traceEnd(int kind, double begin)
+{
+	double const now    = wallTime();
+	int const    thread = omp_get_thread_num();
+
+	if (trace.capacity > 0 && kind != TRACE_NONE && thread < trace.threads)
 	{
-		maxresiduum = 0;
+		struct trace_buffer* buffer = trace.buffers[thread];
+		struct trace_event*  event  = &buffer->events[buffer->count++ % trace.capacity];
 
-		/* over all rows */
-		for (i = 1; i < ranks - 1; i++)
-		{
-			double fpisin_i = 0.0;
+		event->begin = begin;
+		event->end   = now;
+		event->kind  = kind;
+	}
 
-			if (options->inf_func == FUNC_FPISIN)
-			{
-				fpisin_i = fpisin * sin(pih * (double)(i + arguments->row_start));
-			}
+	return now;
+}
 
-			/* over all columns */
-			for (j = 1; j < N; j++)
-			{
-				star = 0.25 * (Matrix[m2][i - 1][j] + Matrix[m2][i][j - 1] + Matrix[m2][i][j + 1] + Matrix[m2][i + 1][j]);
+/* ************************************************************************ */
+/* phaseEvent: adds the time since start to a phase and records it as an    */
+/*             event, returns the current time so that the next phase can   */
+/*             start there                                                  */
+/* ************************************************************************ */
+static double
+phaseEvent(int phase, int kind, double start)
+{
+	double const now = traceEnd(kind, start);
 
-				if (options->inf_func == FUNC_FPISIN)
-				{
-					star += fpisin_i * sin(pih * (double)j);
-				}
+	profile.phase[phase] += now - start;
 
-				if (options->termination == TERM_PREC || term_iteration == 1)
-				{
-					residuum    = Matrix[m2][i][j] - star;
-					residuum    = fabs(residuum);
-					maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
-				}
+	return now;
+}
 
-				Matrix[m1][i][j] = star;
-			}
-		}
+/* ************************************************************************ */
+/* phaseEnd: like phaseEvent with the usual event of the phase              */
+/* ************************************************************************ */
+static double
+phaseEnd(int phase, double start)
+{
+	static int const kinds[] = { TRACE_SWEEP, TRACE_WAIT, TRACE_REDUCE, TRACE_SYNC };
+
+	return phaseEvent(phase, kinds[phase], start);
+}
+
+/* ************************************************************************ */
+/* countBytes: counts values sent to a neighbour (none for MPI_PROC_NULL)   */
+/* ************************************************************************ */
+static void
+countBytes(int neighbour, uint64_t values)
+{
+	if (neighbour != MPI_PROC_NULL)
+	{
+		profile.bytes += values * sizeof(double);
+	}
+}
 
-		// printf("Step 2 %d\n", options->rank);
+/* ************************************************************************ */
+/* checkTermination: counts the iteration and decides whether to stop       */
+/*                                                                          */
+/* TERM_PREC: the residuum of an iteration is reduced with MPI_Iallreduce   */
+/* and only checked options->lag sweeps later, so the reduction overlaps    */
+/* with the computation (and with the pipeline skew of Gauss-Seidel). A run */
+/* therefore stops options->lag iterations after reaching the precision;    */
+/* they are counted in results->stat_lagged.                                */
+/* TERM_ITER: only the last iteration is reduced.                           */
+/* returns the new value of term_iteration                                  */
+/* ************************************************************************ */
+static int
+checkTermination(struct convergence* convergence, double maxresiduum, int term_iteration, MPI_Comm comm, struct calculation_results* results, struct options const* options)
+{
+	double const start = wallTime();
 
-        // isend, irecv = non-blocking events (wichtig für parallelisierung)
+	if (options->termination == TERM_PREC)
+	{
+		int const      slots     = options->lag + 1;
+		uint64_t const iteration = convergence->started++;
+		int const      current   = iteration % slots;
+		int const      checked   = (iteration + slots - options->lag) % slots;
 
-        // Zeilen zwischen den Rängen hin- und herschieben
+		uint64_t i;
 
-        // Außer dem letzten Rang geben alle ihre letzte Zeile zum nächsten Rang
-        if (options->rank != options->size - 1) {
-            MPI_Isend(Matrix[m1][ranks - 2], N + 1, MPI_DOUBLE, options->rank + 1, 0, MPI_COMM_WORLD, &lower[0]);
-            MPI_Irecv(Matrix[m1][ranks - 1], N + 1, MPI_DOUBLE, options->rank + 1, 0, MPI_COMM_WORLD, &upper[1]);
-        }
-        // oberste Zeile auch an oberen Rang schieben
-        if (options->rank != 0) {
-            MPI_Isend(Matrix[m1][1], N + 1, MPI_DOUBLE, options->rank - 1, 0, MPI_COMM_WORLD, &upper[0]);
-            MPI_Irecv(Matrix[m1][0], N + 1, MPI_DOUBLE, options->rank - 1, 0, MPI_COMM_WORLD, &lower[1]);
-        }
-	MPI_Status status;
-        // Warten bis alles da ist
-        if (options->rank != 0) {
-            MPI_Wait(&lower[1], &status);
-            MPI_Wait(&upper[0], &status);
-        }
-        if (options->rank != options->size - 1) {
-            MPI_Wait(&lower[0], &status);
-            MPI_Wait(&upper[1], &status);
-        }
+		// Reduktion dieser Iteration starten, sie läuft während der nächsten Iterationen
+		convergence->local[current] = maxresiduum;
+		MPI_Iallreduce(&(convergence->local[current]), &(convergence->global[current]), 1, MPI_DOUBLE, MPI_MAX, comm, &(convergence->reduction[current]));
 
-		results->stat_iteration++;
-		// results->stat_precision = maxresiduum;
-        MPI_Allreduce(&maxresiduum, &(results->stat_precision), 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+		// Ergebnis von vor lag Iterationen auswerten, alle Ränge entscheiden mit dem globalen Maximum
+		if (iteration >= (uint64_t)options->lag)
+		{
+			MPI_Wait(&(convergence->reduction[checked]), MPI_STATUS_IGNORE);
 
-		/* exchange m1 and m2 */
-		i  = m1;
-		m1 = m2;
-		m2 = i;
+			if (convergence->global[checked] < options->term_precision)
+			{
+				term_iteration       = 0;
+				results->stat_lagged = options->lag;
+			}
+		}
 
-		/* check for stopping calculation depending on termination method */
-		if (options->termination == TERM_PREC)
+		results->stat_iteration++;
+
+		if (term_iteration == 0 || results->stat_iteration == options->term_iteration)
 		{
-			if (maxresiduum < options->term_precision)
+			// noch laufende Reduktionen abschließen, die letzte liefert die Genauigkeit
+			for (i = (iteration >= (uint64_t)options->lag) ? iteration - options->lag + 1 : 0; i <= iteration; i++)
 			{
-				term_iteration = 0;
+				MPI_Wait(&(convergence->reduction[i % slots]), MPI_STATUS_IGNORE);
 			}
+
+			results->stat_precision = convergence->global[current];
+			term_iteration = 0;
 		}
-		else if (options->termination == TERM_ITER)
+	}
+	else if (options->termination == TERM_ITER)
+	{
+		results->stat_iteration++;
+
+		// das Residuum wird nur in der letzten Iteration berechnet und gebraucht
+		if (term_iteration == 1)
 		{
-			term_iteration--;
+			MPI_Allreduce(&maxresiduum, &(results->stat_precision), 1, MPI_DOUBLE, MPI_MAX, comm);
 		}
 
-        MPI_Barrier(MPI_COMM_WORLD);
+		term_iteration--;
 	}
-	// printf("Step 3 %d\n", options->rank);
-	// printf("Finished calculation for %d\n", options->rank);
-	results->m = m2;
+
+	phaseEnd(PHASE_REDUCE, start);
+
+	return term_iteration;
 }
 
 /* ************************************************************************ */
-/* calculate: solves the equation                                           */
+/* waitForFlag: waits until a neighbour on the same node has finished the   */
+/*              given number of iterations                                  */
 /* ************************************************************************ */
 static void
-MPI_Gauss_Seidel_calculate(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
+waitForFlag(atomic_long* flag, long iterations)
 {
-	int    i, j;        /* local variables for loops */
-	int    m1, m2;      /* used as indices for old and new matrices */
-	double star;        /* four times center value minus 4 neigh.b values */
-	double residuum;    /* residuum of current iteration */
-	double maxresiduum; /* maximum residuum value of a slave in iteration */
-
-	MPI_Status status;
-	// MPI_Request upper[2];
-	// MPI_Request lower[2];
-	int const    N = arguments->N;
-	double const h = arguments->h;
+	double const start = wallTime();
 
-	double pih    = 0.0;
-	double fpisin = 0.0;
+	while (atomic_load_explicit(flag, memory_order_acquire) < iterations)
+	{
+		sched_yield();
+	}
 
-	int term_iteration = options->term_iteration;
-	bool first_iteration = true;
+	phaseEnd(PHASE_SYNC, start);
+}
 
-	typedef double(*matrix)[arguments->ranks][N + 1];
-	// printf("Step0 %d\n",options->rank);
+/* ************************************************************************ */
+/* pinThread: binds the calling OpenMP thread to one CPU of the rank        */
+/*                                                                          */
+/* The CPUs are taken from the affinity mask the rank was started with      */
+/* (e.g. srun -c), so all threads stay inside the rank's NUMA domain.       */
+/* If OMP_PROC_BIND is set, the OpenMP runtime is left in charge.           */
+/* ************************************************************************ */
+static void
+pinThread(cpu_set_t const* allowed)
+{
+	int const count  = CPU_COUNT(allowed);
+	int const thread = omp_get_thread_num();
 
-	matrix Matrix = (matrix)arguments->M;
+	cpu_set_t own;
+	int cpu, found = 0;
 
-	/* initialize m1 and m2 depending on algorithm */
-	if (options->method == METH_JACOBI)
+	if (getenv("OMP_PROC_BIND") != NULL || count <= 1 || omp_get_num_threads() <= 1)
 	{
-		m1 = 0;
-		m2 = 1;
+		return;
 	}
-	else
+
+	for (cpu = 0; cpu < CPU_SETSIZE; cpu++)
 	{
-		m1 = 0;
-		m2 = 0;
+		if (CPU_ISSET(cpu, allowed) && found++ == thread % count)
+		{
+			CPU_ZERO(&own);
+			CPU_SET(cpu, &own);
+			sched_setaffinity(0, sizeof(own), &own);
+			return;
+		}
 	}
+}
 
-	if (options->inf_func == FUNC_FPISIN)
+/* ************************************************************************ */
+/* haloInit: prepares the halo exchange of the strip decomposition          */
+/*                                                                          */
+/* Every iteration the rows 1 and ranks - 2 of the new matrix are sent to   */
+/* the halo rows of the neighbours. Sides that are read directly through    */
+/* shared memory are left out (MPI_PROC_NULL).                              */
+/* ************************************************************************ */
+static void
+haloInit(struct halo* halo, struct calculation_arguments const* arguments, struct options const* options)
+{
+	int const N     = arguments->N;
+	int const ranks = arguments->ranks;
+	int       side, m, degree;
+
+	uint64_t  remote_ranks[2];
+	int const weights[2] = { 1, 1 };
+
+	// ohne Nachbarn gibt es nichts auszutauschen (und Open MPI lehnt manche Fenster mit einem Rang ab)
+	halo->method = (options->size > 1) ? options->halo : HALO_ISEND;
+	halo->rank   = options->rank;
+	halo->comm   = options->comm;
+	halo->time   = 0.0;
+
+	halo->neighbours[DIR_UP]   = (options->rank > 0 && arguments->shared[DIR_UP] == NULL) ? options->rank - 1 : MPI_PROC_NULL;
+	halo->neighbours[DIR_DOWN] = (options->rank < options->size - 1 && arguments->shared[DIR_DOWN] == NULL) ? options->rank + 1 : MPI_PROC_NULL;
+
+	if (halo->method == HALO_PERSISTENT)
 	{
-		pih    = M_PI * h;
-		fpisin = 0.25 * (2 * M_PI * M_PI) * h * h;
-	}
+		// ein Satz Requests für jede der beiden Matrizen, danach nur noch MPI_Startall
+		for (m = 0; m < (int)arguments->num_matrices; m++)
+		{
+			double* matrix = arguments->M + (uint64_t)m * ranks * (N + 1);
 
-	// printf("Step1 %d\n", options->rank);
-	if (options->rank > 0) {
-		// printf("Titeration= %d\n", term_iteration);
+			MPI_Send_init(matrix + (N + 1), N + 1, MPI_DOUBLE, halo->neighbours[DIR_UP], 0, options->comm, &halo->requests[m][0]);
+			MPI_Recv_init(matrix, N + 1, MPI_DOUBLE, halo->neighbours[DIR_UP], 0, options->comm, &halo->requests[m][1]);
+			MPI_Send_init(matrix + (ranks - 2) * (N + 1), N + 1, MPI_DOUBLE, halo->neighbours[DIR_DOWN], 0, options->comm, &halo->requests[m][2]);
+			MPI_Recv_init(matrix + (ranks - 1) * (N + 1), N + 1, MPI_DOUBLE, halo->neighbours[DIR_DOWN], 0, options->comm, &halo->requests[m][3]);
+		}
 	}
-	while (term_iteration > 0)
+	else if (halo->method == HALO_NEIGHBOR)
 	{
-		if (options->rank > 0) {
-			// printf("Titeration= %d\n", term_iteration);
-		}
-		maxresiduum = 0;
-		if (options->rank > 0) {
-			// printf("Im here");
-		}
-		if(options->termination == TERM_PREC){
-			if(!first_iteration && options->rank < options-> size - 1){
-				// printf("waiting01 %d\n", options->rank);
-				MPI_Recv(&term_iteration, 1, MPI_INT, MPI_ANY_SOURCE, 420, MPI_COMM_WORLD, &status);
-				// printf("Got it01 %d\n", options->rank);
-
-				if(options->rank < options->size-1 -1){
-					MPI_Send(&term_iteration, 1, MPI_INT, options->rank + 1, 420, MPI_COMM_WORLD);
-				}
+		// Graph nur mit den echten Nachbarn, Reihenfolge oben vor unten
+		degree = 0;
 
-				if(term_iteration == 0){
-					break;
-				}
-			
-				if(options->rank > 0){
-					// printf("Waiting...");
-					MPI_Recv(&maxresiduum, 1, MPI_INT, options->rank - 1, 423, MPI_COMM_WORLD, &status);
-					// printf("Got it!");
-				}
+		for (side = 0; side < 2; side++)
+		{
+			if (halo->neighbours[side] != MPI_PROC_NULL)
+			{
+				halo->graph_neighbours[degree] = halo->neighbours[side];
+				halo->counts[degree]           = N + 1;
+				halo->sdispls[degree]          = (side == DIR_UP) ? (N + 1) : (ranks - 2) * (N + 1);
+				halo->rdispls[degree]          = (side == DIR_UP) ? 0 : (ranks - 1) * (N + 1);
+				degree++;
 			}
 		}
-		
-		/* empfange Zeile vom vorherigen Rang */
-		if(options->rank > 0)
+
+		// gleiche Gewichte statt MPI_UNWEIGHTED, das gcc als leeres Feld ansieht
+		MPI_Dist_graph_create_adjacent(options->comm, degree, halo->graph_neighbours, weights, degree, halo->graph_neighbours, weights, MPI_INFO_NULL, 0, &halo->graph);
+	}
+	else if (halo->method == HALO_PUT)
+	{
+		// Zeilenzahl der Nachbarn, um die Lage ihrer Halo-Zeilen im Fenster zu kennen
+		MPI_Sendrecv(&arguments->ranks, 1, MPI_UINT64_T, halo->neighbours[DIR_DOWN], 0, &remote_ranks[DIR_UP], 1, MPI_UINT64_T, halo->neighbours[DIR_UP], 0, options->comm, MPI_STATUS_IGNORE);
+		MPI_Sendrecv(&arguments->ranks, 1, MPI_UINT64_T, halo->neighbours[DIR_UP], 0, &remote_ranks[DIR_DOWN], 1, MPI_UINT64_T, halo->neighbours[DIR_DOWN], 0, options->comm, MPI_STATUS_IGNORE);
+
+		for (m = 0; m < (int)arguments->num_matrices; m++)
 		{
-			// printf("Wating02");
-			MPI_Recv(Matrix[m1][0], N + 1, MPI_DOUBLE, options->rank - 1, 422, MPI_COMM_WORLD, &status);
-			// printf("Got it02");
-			// MPI_Wait(&lower[1], &status);
-		}
-		
-		/* empfange Zeile vom nächsten Rang, wenn die erste Iteration abgeschlossen ist */
-		if(!first_iteration && options->rank < options->size - 1){
-			MPI_Recv(Matrix[m1][arguments->ranks - 1], N + 1, MPI_DOUBLE, options->rank + 1, 421, MPI_COMM_WORLD, &status);
-		}
-		if (options->rank > 0) {
-			// printf("Debug1");
+			// oben landet unsere Zeile 1 in der letzten Zeile, unten unsere Zeile ranks - 2 in Zeile 0
+			halo->displacements[m][DIR_UP]   = (MPI_Aint)((m + 1) * remote_ranks[DIR_UP] - 1) * (N + 1);
+			halo->displacements[m][DIR_DOWN] = (MPI_Aint)(m * remote_ranks[DIR_DOWN]) * (N + 1);
 		}
 
-		/* over all rows */
-		for (i = 1; i < (int)arguments->ranks - 1; i++)
-		{
-			double fpisin_i = 0.0;
+		MPI_Win_create(arguments->M, arguments->num_matrices * ranks * (N + 1) * sizeof(double), sizeof(double), MPI_INFO_NULL, options->comm, &halo->window);
+		MPI_Win_allocate(2 * sizeof(long), sizeof(long), MPI_INFO_NULL, options->comm, &halo->flag, &halo->flag_window);
 
-			if (options->inf_func == FUNC_FPISIN)
-			{
-				/* Index der Startzeile zu i addieren */
-				fpisin_i = fpisin * sin(pih * (double)(i + arguments->row_start));
+		halo->flag[DIR_UP]   = 0;
+		halo->flag[DIR_DOWN] = 0;
+
+		// passive Synchronisation für die ganze Laufzeit
+		MPI_Win_lock_all(MPI_MODE_NOCHECK, halo->window);
+		MPI_Win_lock_all(MPI_MODE_NOCHECK, halo->flag_window);
+
+		// die Zähler sind initialisiert, bevor jemand sie verändert
+		MPI_Barrier(options->comm);
+	}
+}
+
+/* ************************************************************************ */
+/* haloStart: starts sending the boundary rows of matrix m                  */
+/* ************************************************************************ */
+static void
+haloStart(struct halo* halo, struct calculation_arguments const* arguments, int m)
+{
+	int const N     = arguments->N;
+	int const ranks = arguments->ranks;
+	int       side;
+
+	double* matrix = arguments->M + (uint64_t)m * ranks * (N + 1);
+	double  start  = wallTime();
+
+	halo->matrix = m;
+
+	for (side = 0; side < 2; side++)
+	{
+		countBytes(halo->neighbours[side], N + 1);
+	}
+
+	switch (halo->method)
+	{
+		case HALO_ISEND:
+			MPI_Isend(matrix + (N + 1), N + 1, MPI_DOUBLE, halo->neighbours[DIR_UP], 0, halo->comm, &halo->requests[m][0]);
+			MPI_Irecv(matrix, N + 1, MPI_DOUBLE, halo->neighbours[DIR_UP], 0, halo->comm, &halo->requests[m][1]);
+			MPI_Isend(matrix + (ranks - 2) * (N + 1), N + 1, MPI_DOUBLE, halo->neighbours[DIR_DOWN], 0, halo->comm, &halo->requests[m][2]);
+			MPI_Irecv(matrix + (ranks - 1) * (N + 1), N + 1, MPI_DOUBLE, halo->neighbours[DIR_DOWN], 0, halo->comm, &halo->requests[m][3]);
+			break;
+
+		case HALO_PERSISTENT:
+			MPI_Startall(4, halo->requests[m]);
+			break;
+
+		case HALO_NEIGHBOR:
+			MPI_Ineighbor_alltoallv(matrix, halo->counts, halo->sdispls, MPI_DOUBLE, matrix, halo->counts, halo->rdispls, MPI_DOUBLE, halo->graph, &halo->requests[0][0]);
+			break;
+
+		case HALO_PUT:
+			for (side = 0; side < 2; side++)
+			{
+				if (halo->neighbours[side] != MPI_PROC_NULL)
+				{
+					MPI_Put(matrix + ((side == DIR_UP) ? 1 : ranks - 2) * (N + 1), N + 1, MPI_DOUBLE, halo->neighbours[side], halo->displacements[m][side], N + 1, MPI_DOUBLE, halo->window);
+				}
+			}
+			break;
+	}
+
+	halo->time += phaseEvent(PHASE_HALO, TRACE_SEND, start) - start;
+}
+
+/* ************************************************************************ */
+/* haloWait: completes the exchange, afterwards the halo rows are valid     */
+/*                                                                          */
+/* For MPI_Put every rank counts the finished iterations of its neighbours  */
+/* in its flag window. A rank only continues when both neighbours have put  */
+/* their rows, so they are also done reading the rows we overwrite next.    */
+/* ************************************************************************ */
+static void
+haloWait(struct halo* halo, uint64_t iteration)
+{
+	long const done = iteration + 1;
+	long       value;
+	int        side;
+
+	double start = wallTime();
+
+	switch (halo->method)
+	{
+		case HALO_ISEND:
+		case HALO_PERSISTENT:
+			MPI_Waitall(4, halo->requests[halo->matrix], MPI_STATUSES_IGNORE);
+			break;
+
+		case HALO_NEIGHBOR:
+			MPI_Wait(&halo->requests[0][0], MPI_STATUS_IGNORE);
+			break;
+
+		case HALO_PUT:
+			MPI_Win_flush_all(halo->window);
+
+			// dem Nachbarn mitteilen, dass die Zeile da ist (oben: sein unterer Zähler)
+			for (side = 0; side < 2; side++)
+			{
+				if (halo->neighbours[side] != MPI_PROC_NULL)
+				{
+					MPI_Accumulate(&done, 1, MPI_LONG, halo->neighbours[side], 1 - side, 1, MPI_LONG, MPI_REPLACE, halo->flag_window);
+				}
+			}
+
+			MPI_Win_flush_all(halo->flag_window);
+
+			for (side = 0; side < 2; side++)
+			{
+				if (halo->neighbours[side] == MPI_PROC_NULL)
+				{
+					continue;
+				}
+
+				do
+				{
+					MPI_Fetch_and_op(NULL, &value, MPI_LONG, halo->rank, side, MPI_NO_OP, halo->flag_window);
+					MPI_Win_flush(halo->rank, halo->flag_window);
+				}
+				while (value < done);
+			}
+
+			MPI_Win_sync(halo->window);
+			break;
+	}
+
+	halo->time += phaseEnd(PHASE_HALO, start) - start;
+}
+
+/* ************************************************************************ */
+/* haloFree: releases the requests, communicators and windows of the halo   */
+/* ************************************************************************ */
+static void
+haloFree(struct halo* halo, struct calculation_arguments const* arguments)
+{
+	int m, i;
+
+	if (halo->method == HALO_PERSISTENT)
+	{
+		for (m = 0; m < (int)arguments->num_matrices; m++)
+		{
+			for (i = 0; i < 4; i++)
+			{
+				MPI_Request_free(&halo->requests[m][i]);
+			}
+		}
+	}
+	else if (halo->method == HALO_NEIGHBOR)
+	{
+		MPI_Comm_free(&halo->graph);
+	}
+	else if (halo->method == HALO_PUT)
+	{
+		MPI_Win_unlock_all(halo->flag_window);
+		MPI_Win_unlock_all(halo->window);
+		MPI_Win_free(&halo->flag_window);
+		MPI_Win_free(&halo->window);
+	}
+}
+
+/* ************************************************************************ */
+/* calculate: solves the equation for Jacobi                                */
+/*                                                                          */
+/* Every rank uses options->number OpenMP threads for its strip. The master */
+/* thread computes the boundary rows and posts the halo exchange while the  */
+/* other threads start on the inner rows; it joins them afterwards, since   */
+/* the inner rows are handed out dynamically. All MPI calls are made by the */
+/* master thread (MPI_THREAD_FUNNELED).                                     */
+/* ************************************************************************ */
+static void
+MPI_jacobi_calculate(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
+{
+    // für nachfolgendes hin- und herreichen der Zeilen zwischen den Ränken
+    struct halo halo;
+    double halo_time;
+
+    // Beginn der Rechenzeit einer Iteration und der laufenden Phase (nur Master-Thread)
+    double sweep_start = 0.0;
+    double phase_start = 0.0;
+
+    uint64_t const first_iteration = results->stat_iteration;
+
+    // Gewicht der Tschebyscheff-Beschleunigung, vom Master-Thread fortgeschrieben
+    double omega = 1.0;
+
+    // nicht-blockierende Reduktion des Residuums, wird eine Iteration später ausgewertet
+    struct convergence convergence = { .started = 0 };
+
+	int    m1, m2;      /* used as indices for old and new matrices */
+
+	int const    N = arguments->N;
+    int const ranks = arguments->ranks;
+	double const h = arguments->h;
+
+	double pih    = 0.0;
+	double fpisin = 0.0;
+
+	int term_iteration = options->term_iteration;
+
+	// Residuum jedes Threads, wird vom Master-Thread zusammengefasst
+	double thread_residuum[options->number];
+
+	cpu_set_t allowed;
+
+	typedef double(*matrix)[ranks][N + 1];
+
+	matrix Matrix = (matrix)arguments->M;
+
+	/* initialize m1 and m2 depending on algorithm */
+	if (JACOBI_SWEEPS(options->method))
+	{
+		m1 = 0;
+		m2 = 1;
+	}
+	else
+	{
+		m1 = 0;
+		m2 = 0;
+	}
+
+	if (options->inf_func == FUNC_FPISIN)
+	{
+		pih    = M_PI * h;
+		fpisin = 0.25 * (2 * M_PI * M_PI) * h * h;
+	}
+
+	CPU_ZERO(&allowed);
+	sched_getaffinity(0, sizeof(allowed), &allowed);
+
+	// die Iterationszähler im Shared Memory zählen ab diesem Aufruf (siehe MPI_jacobi_balanced)
+	if (arguments->window != MPI_WIN_NULL)
+	{
+		phase_start = wallTime();
+		MPI_Barrier(arguments->node_comm);
+		atomic_store(arguments->flag, 0);
+		MPI_Barrier(arguments->node_comm);
+		phaseEnd(PHASE_SYNC, phase_start);
+	}
+
+	haloInit(&halo, arguments, options);
+
+	#pragma omp parallel num_threads(options->number)
+	{
+		int const thread = omp_get_thread_num();
+		int i;
+
+		pinThread(&allowed);
+
+		while (term_iteration > 0)
+		{
+			bool const residual = (options->termination == TERM_PREC || term_iteration == 1);
+
+			double maxresiduum = 0;
+
+			#pragma omp master
+			{
+				// Halo-Zeilen: eigene Kopie oder bei Nachbarn auf demselben Knoten direkt deren Randzeile
+				double const* up   = Matrix[m2][0];
+				double const* down = Matrix[m2][ranks - 1];
+
+				if (arguments->shared[0] != NULL)
+				{
+					up = arguments->shared[0] + (m2 * arguments->shared_ranks[0] + arguments->shared_ranks[0] - 2) * (N + 1);
+				}
+
+				if (arguments->shared[1] != NULL)
+				{
+					down = arguments->shared[1] + (m2 * arguments->shared_ranks[1] + 1) * (N + 1);
+				}
+
+				// Nachbarn müssen die letzte Iteration abgeschlossen haben: ihre Randzeilen sind fertig
+				// und sie lesen unsere Randzeilen in m1 nicht mehr
+				if (arguments->window != MPI_WIN_NULL)
+				{
+					for (i = 0; i < 2; i++)
+					{
+						if (arguments->shared_flag[i] != NULL)
+						{
+							waitForFlag(arguments->shared_flag[i], results->stat_iteration - first_iteration);
+						}
+					}
+
+					MPI_Win_sync(arguments->window);
+				}
+
+				sweep_start = MPI_Wtime();
+				phase_start = wallTime();
+
+				// Zuerst nur die Randzeilen berechnen, die die Nachbarn brauchen
+				if (ranks - 2 >= 1)
+				{
+					maxresiduum = jacobiRow(Matrix[m1][1], up, Matrix[m2][1], (ranks - 2 > 1) ? Matrix[m2][2] : down, 1, N, 0, fpisinRow(arguments, options, fpisin, pih, 1), pih, omega, residual, maxresiduum);
+				}
+
+				if (ranks - 2 > 1)
+				{
+					maxresiduum = jacobiRow(Matrix[m1][ranks - 2], Matrix[m2][ranks - 3], Matrix[m2][ranks - 2], down, 1, N, 0, fpisinRow(arguments, options, fpisin, pih, ranks - 2), pih, omega, residual, maxresiduum);
+				}
+
+				// Randzeilen dieser Iteration freigeben
+				if (arguments->window != MPI_WIN_NULL)
+				{
+					MPI_Win_sync(arguments->window);
+					atomic_store_explicit(arguments->flag, results->stat_iteration - first_iteration + 1, memory_order_release);
+				}
+
+				// Die Halo-Zeilen von m1 werden in dieser Iteration nicht gelesen,
+				// der Austausch kann also laufen, während das Innere berechnet wird
+				phaseEnd(PHASE_COMPUTE, phase_start);
+				haloStart(&halo, arguments, m1);
+				phase_start = wallTime();
+			}
+
+			double const begin = wallTime();
+
+			/* over all inner rows, the barrier below waits for everyone */
+			#pragma omp for schedule(guided) nowait
+			for (i = 2; i < ranks - 2; i++)
+			{
+				maxresiduum = jacobiRow(Matrix[m1][i], Matrix[m2][i - 1], Matrix[m2][i], Matrix[m2][i + 1], 1, N, 0, fpisinRow(arguments, options, fpisin, pih, i), pih, omega, residual, maxresiduum);
+			}
+
+			traceEnd(TRACE_SWEEP, begin);
+			thread_residuum[thread] = maxresiduum;
+
+			#pragma omp barrier
+
+			#pragma omp master
+			{
+				// Rechenzeit ohne Warten auf die Nachbarn, für die Lastverteilung
+				results->sweep_time += MPI_Wtime() - sweep_start;
+				phaseEvent(PHASE_COMPUTE, TRACE_NONE, phase_start);
+
+				// Warten bis alles da ist
+				haloWait(&halo, results->stat_iteration);
+
+				for (i = 1; i < omp_get_num_threads(); i++)
+				{
+					maxresiduum = (thread_residuum[i] < maxresiduum) ? maxresiduum : thread_residuum[i];
+				}
+
+				/* exchange m1 and m2 */
+				i  = m1;
+				m1 = m2;
+				m2 = i;
+
+				/* check for stopping calculation depending on termination method */
+				term_iteration = checkTermination(&convergence, maxresiduum, term_iteration, options->comm, results, options);
+
+				omega = chebyshevOmega(options, cos(M_PI * h), omega, results->stat_iteration - first_iteration);
+			}
+
+			// alle Threads müssen die neuen m1, m2, omega und term_iteration sehen
+			#pragma omp barrier
+		}
+	}
+
+	// erst zurückkehren, wenn die Nachbarn unsere Randzeilen nicht mehr lesen
+	for (int side = 0; side < 2; side++)
+	{
+		if (arguments->shared_flag[side] != NULL)
+		{
+			waitForFlag(arguments->shared_flag[side], results->stat_iteration - first_iteration);
+		}
+	}
+
+	haloFree(&halo, arguments);
+
+	// Zeit pro Iteration, gemittelt und als Maximum über die Ränge
+	halo_time = halo.time / (results->stat_iteration - first_iteration);
+	MPI_Reduce(&halo_time, &results->halo_time[0], 1, MPI_DOUBLE, MPI_SUM, 0, options->comm);
+	MPI_Reduce(&halo_time, &results->halo_time[1], 1, MPI_DOUBLE, MPI_MAX, 0, options->comm);
+	results->halo_time[0] /= options->size;
+
+	results->m = m2;
+}
+
+/* ************************************************************************ */
+/* rebalance: redistributes the inner rows in proportion to the measured    */
+/*            throughput of the ranks                                       */
+/*                                                                          */
+/* Every rank reports how many rows per second it computed since the last   */
+/* redistribution (results->sweep_time excludes waiting for neighbours).    */
+/* All ranks derive the same new row boundaries from that. The current      */
+/* matrix is then moved into freshly allocated matrices with one            */
+/* MPI_Alltoallv; rows only travel between ranks whose old and new ranges   */
+/* overlap, which are neighbours or near neighbours.                        */
+/* ************************************************************************ */
+static void
+rebalance(struct calculation_arguments* arguments, struct calculation_results* results, struct options const* options, uint64_t iterations)
+{
+	int const size  = options->size;
+	int const N     = arguments->N;
+	int const inner = N - 1;
+
+	struct calculation_arguments next = *arguments;
+
+	MPI_Datatype row;
+	int          r, q;
+
+	// eigene innere Zeilen lo .. hi und Durchsatz in Zeilen pro Sekunde
+	double const own        = arguments->ranks - 2;
+	double const throughput = (results->sweep_time > 0.0) ? own * iterations / results->sweep_time : 1.0;
+
+	double rates[size];
+	int    old_range[2 * size];
+	int    new_range[2 * size];
+	int    range[2] = { arguments->row_start + 1, arguments->row_start + arguments->ranks - 2 };
+
+	int send_counts[size], send_displs[size];
+	int recv_counts[size], recv_displs[size];
+
+	double total = 0.0, sum = 0.0;
+
+	MPI_Allgather(&throughput, 1, MPI_DOUBLE, rates, 1, MPI_DOUBLE, options->comm);
+	MPI_Allgather(range, 2, MPI_INT, old_range, 2, MPI_INT, options->comm);
+
+	for (r = 0; r < size; r++)
+	{
+		total += rates[r];
+	}
+
+	// neue Grenzen proportional zum Durchsatz, jeder Rang behält mindestens eine Zeile
+	for (r = 0; r < size; r++)
+	{
+		int lo = (r == 0) ? 1 : new_range[2 * r - 1] + 1;
+		int hi;
+
+		sum += rates[r];
+		hi = (r == size - 1) ? inner : (int)(inner * sum / total + 0.5);
+
+		hi = (hi < lo) ? lo : hi;
+		hi = (hi > inner - (size - 1 - r)) ? inner - (size - 1 - r) : hi;
+
+		new_range[2 * r]     = lo;
+		new_range[2 * r + 1] = hi;
+	}
+
+	// die Randzeilen 0 und N gehören dem ersten und letzten Rang
+	old_range[0] = 0;
+	old_range[2 * size - 1] = N;
+
+	// jeder Rang braucht seine Zeilen und je eine Halo-Zeile
+	int const need[2] = { new_range[2 * options->rank] - 1, new_range[2 * options->rank + 1] + 1 };
+
+	for (q = 0; q < size; q++)
+	{
+		// an q: Überschneidung unserer alten Zeilen mit dem Bedarf von q
+		int const lo = (old_range[2 * options->rank] > new_range[2 * q] - 1) ? old_range[2 * options->rank] : new_range[2 * q] - 1;
+		int const hi = (old_range[2 * options->rank + 1] < new_range[2 * q + 1] + 1) ? old_range[2 * options->rank + 1] : new_range[2 * q + 1] + 1;
+
+		send_counts[q] = (hi >= lo) ? hi - lo + 1 : 0;
+		send_displs[q] = (hi >= lo) ? lo - arguments->row_start : 0;
+
+		// von q: Überschneidung der alten Zeilen von q mit unserem Bedarf
+		int const from = (old_range[2 * q] > need[0]) ? old_range[2 * q] : need[0];
+		int const to   = (old_range[2 * q + 1] < need[1]) ? old_range[2 * q + 1] : need[1];
+
+		recv_counts[q] = (to >= from) ? to - from + 1 : 0;
+		recv_displs[q] = (to >= from) ? from - need[0] : 0;
+	}
+
+	next.row_start = need[0];
+	next.row_end   = need[1];
+	next.ranks     = need[1] - need[0] + 1;
+
+	allocateMatrices(&next, options);
+
+	MPI_Type_contiguous(N + 1, MPI_DOUBLE, &row);
+	MPI_Type_commit(&row);
+
+	MPI_Alltoallv(arguments->M + results->m * arguments->ranks * (N + 1), send_counts, send_displs, row, next.M, recv_counts, recv_displs, row, options->comm);
+
+	MPI_Type_free(&row);
+
+	// Jacobi liest nur die alte Matrix, beide Matrizen starten mit dem aktuellen Stand
+	memcpy(next.M + next.ranks * (N + 1), next.M, next.ranks * (N + 1) * sizeof(double));
+
+	freeMatrices(arguments);
+	*arguments = next;
+
+	results->m          = 0;
+	results->sweep_time = 0.0;
+	results->rebalances++;
+
+	int rows = next.ranks - 2;
+
+	MPI_Allreduce(&rows, &results->rows[0], 1, MPI_INT, MPI_MIN, options->comm);
+	MPI_Allreduce(&rows, &results->rows[1], 1, MPI_INT, MPI_MAX, options->comm);
+}
+
+/* ************************************************************************ */
+/* calculate: solves the equation for Jacobi with load balancing            */
+/*                                                                          */
+/* Runs MPI_jacobi_calculate in phases: options->balance[0] iterations to   */
+/* measure, then the rows are redistributed (see rebalance). With           */
+/* options->balance[1] > 0 this is repeated after every balance[1]          */
+/* iterations. A phase ends with all reductions completed, so a run that    */
+/* already reached the precision stops at the end of the phase.             */
+/* ************************************************************************ */
+static void
+MPI_jacobi_balanced(struct calculation_arguments* arguments, struct calculation_results* results, struct options const* options)
+{
+	struct options phase = *options;
+
+	uint64_t length = options->balance[0];
+	uint64_t start;
+
+	while (true)
+	{
+		start = results->stat_iteration;
+
+		// Iterationen dieser Phase, bei TERM_PREC als Obergrenze für stat_iteration
+		if (options->termination == TERM_ITER)
+		{
+			phase.term_iteration = (length < options->term_iteration - start) ? length : options->term_iteration - start;
+		}
+		else
+		{
+			phase.term_iteration = (length < options->term_iteration - start) ? start + length : options->term_iteration;
+		}
+
+		MPI_jacobi_calculate(arguments, results, &phase);
+
+		// fertig: Iterationen aufgebraucht oder Genauigkeit erreicht
+		if (results->stat_iteration >= options->term_iteration || results->stat_iteration - start < length)
+		{
+			break;
+		}
+
+		if (options->termination == TERM_PREC && results->stat_precision < options->term_precision)
+		{
+			break;
+		}
+
+		rebalance(arguments, results, options, results->stat_iteration - start);
+
+		// ohne Intervall läuft der Rest in einer Phase
+		length = (options->balance[1] > 0) ? (uint64_t)options->balance[1] : options->term_iteration;
+	}
+}
+
+/* ************************************************************************ */
+/* calculate: solves the equation for Jacobi with deep halos                */
+/*                                                                          */
+/* Every rank keeps depth halo rows per side and exchanges them only every  */
+/* depth iterations. In between it also computes the rows of its neighbours */
+/* that are still valid: after s iterations of a cycle the outermost s      */
+/* halo rows are stale, so the computed range shrinks by one row per side   */
+/* and iteration until only the own rows are left. The arithmetic is the    */
+/* same as with one halo row, so the results are identical.                 */
+/* ************************************************************************ */
+static void
+MPI_jacobi_calculate_deep(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
+{
+	MPI_Request requests[4];
+
+	struct convergence convergence = { .started = 0 };
+
+	int    i, s;        /* local variables for loops */
+	int    m1, m2;      /* used as indices for old and new matrices */
+	double maxresiduum; /* maximum residuum value of a slave in iteration */
+	double start;
+
+	int const    N     = arguments->N;
+	int const    ranks = arguments->ranks;
+	int const    depth = options->depth;
+	double const h     = arguments->h;
+
+	int const upper = (options->rank > 0) ? options->rank - 1 : MPI_PROC_NULL;
+	int const lower = (options->rank < options->size - 1) ? options->rank + 1 : MPI_PROC_NULL;
+
+	// eigene Zeilen, an den Rändern der Matrix ohne Geisterzeilen
+	int const own_first = (upper != MPI_PROC_NULL) ? depth : 1;
+	int const own_last  = (lower != MPI_PROC_NULL) ? ranks - 1 - depth : ranks - 2;
+
+	double pih    = 0.0;
+	double fpisin = 0.0;
+	double halo_time = 0.0;
+
+	int term_iteration = options->term_iteration;
+
+	typedef double(*matrix)[ranks][N + 1];
+
+	matrix Matrix = (matrix)arguments->M;
+
+	m1 = 0;
+	m2 = 1;
+
+	if (options->inf_func == FUNC_FPISIN)
+	{
+		pih    = M_PI * h;
+		fpisin = 0.25 * (2 * M_PI * M_PI) * h * h;
+	}
+
+	while (term_iteration > 0)
+	{
+		// depth eigene Zeilen in die Geisterzeilen der Nachbarn, ein Block pro Seite
+		start = wallTime();
+
+		MPI_Isend(Matrix[m2][own_first], depth * (N + 1), MPI_DOUBLE, upper, 0, options->comm, &requests[0]);
+		MPI_Irecv(Matrix[m2][0], depth * (N + 1), MPI_DOUBLE, upper, 0, options->comm, &requests[1]);
+		MPI_Isend(Matrix[m2][own_last - depth + 1], depth * (N + 1), MPI_DOUBLE, lower, 0, options->comm, &requests[2]);
+		MPI_Irecv(Matrix[m2][ranks - depth], depth * (N + 1), MPI_DOUBLE, lower, 0, options->comm, &requests[3]);
+		MPI_Waitall(4, requests, MPI_STATUSES_IGNORE);
+		countBytes(upper, depth * (N + 1));
+		countBytes(lower, depth * (N + 1));
+
+		halo_time += traceEnd(TRACE_WAIT, start) - start;
+
+		for (s = 0; s < depth && term_iteration > 0; s++)
+		{
+			bool const residual = (options->termination == TERM_PREC || term_iteration == 1);
+
+			// mit jeder Iteration ist eine Geisterzeile mehr veraltet
+			int const first = (upper != MPI_PROC_NULL) ? 1 + s : 1;
+			int const last  = (lower != MPI_PROC_NULL) ? ranks - 2 - s : ranks - 2;
+
+			maxresiduum = 0;
+			start       = wallTime();
+
+			/* over all rows, only the own rows count for the residuum */
+			#pragma omp parallel for num_threads(options->number) schedule(static) reduction(max:maxresiduum)
+			for (i = first; i <= last; i++)
+			{
+				bool const own = (i >= own_first && i <= own_last);
+
+				maxresiduum = jacobiRow(Matrix[m1][i], Matrix[m2][i - 1], Matrix[m2][i], Matrix[m2][i + 1], 1, N, 0, fpisinRow(arguments, options, fpisin, pih, i), pih, 1.0, residual && own, maxresiduum);
+			}
+
+			traceEnd(TRACE_SWEEP, start);
+
+			/* exchange m1 and m2 */
+			i  = m1;
+			m1 = m2;
+			m2 = i;
+
+			term_iteration = checkTermination(&convergence, maxresiduum, term_iteration, options->comm, results, options);
+		}
+	}
+
+	// Zeit pro Iteration, gemittelt und als Maximum über die Ränge
+	profile.phase[PHASE_HALO] += halo_time;
+	halo_time /= results->stat_iteration;
+	MPI_Reduce(&halo_time, &results->halo_time[0], 1, MPI_DOUBLE, MPI_SUM, 0, options->comm);
+	MPI_Reduce(&halo_time, &results->halo_time[1], 1, MPI_DOUBLE, MPI_MAX, 0, options->comm);
+	results->halo_time[0] /= options->size;
+
+	results->m = m2;
+}
+
+/* ************************************************************************ */
+/* calculate: solves the equation for Jacobi without lockstep (--async)     */
+/*                                                                          */
+/* Every rank sweeps its strip as fast as it can. After each sweep it puts  */
+/* its boundary rows into an inbox of the neighbours (a window with one row */
+/* per side) and before each sweep it takes whatever its own inbox holds.   */
+/* The rows are written with MPI_Accumulate(MPI_REPLACE) and read with      */
+/* MPI_Get_accumulate(MPI_NO_OP), which are atomic per element, so a halo   */
+/* may be mixed from two sweeps of the neighbour, but no value is torn.     */
+/* The iteration still converges because the matrix is diagonally dominant.*/
+/*                                                                          */
+/* TERM_PREC: the residua of the latest sweeps are reduced with             */
+/* MPI_Iallreduce, which is only tested between sweeps. When it completes   */
+/* with a maximum below the precision all ranks stop, otherwise the next    */
+/* one is started. A rank that reached term_iteration sweeps votes for the  */
+/* stop and waits. TERM_ITER: every rank does term_iteration sweeps.        */
+/* ************************************************************************ */
+static void
+MPI_jacobi_async(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
+{
+	MPI_Win     window;
+	MPI_Request reduction = MPI_REQUEST_NULL;
+
+	int    i;           /* local variables for loops */
+	int    m1, m2;      /* used as indices for old and new matrices */
+	double maxresiduum = 0.0; /* maximum residuum value of a slave in iteration */
+	double start;
+
+	int const    N     = arguments->N;
+	int const    ranks = arguments->ranks;
+	double const h     = arguments->h;
+
+	int const neighbours[2] = {
+		(options->rank > 0) ? options->rank - 1 : MPI_PROC_NULL,
+		(options->rank < options->size - 1) ? options->rank + 1 : MPI_PROC_NULL
+	};
+
+	// Halo-Zeile jeder Seite und die eigene Randzeile, die der Nachbar dort braucht
+	int const halo_rows[2] = { 0, ranks - 1 };
+	int const send_rows[2] = { 1, ranks - 2 };
+
+	uint64_t sweeps = 0;
+	uint64_t counts[2];
+
+	bool   pending = false;
+	int    done, side;
+	double local, global = 0.0;
+
+	double* inbox = NULL;
+	double  pih    = 0.0;
+	double  fpisin = 0.0;
+	double  halo_time = 0.0;
+
+	typedef double(*matrix)[ranks][N + 1];
+
+	matrix Matrix = (matrix)arguments->M;
+
+	m1 = 0;
+	m2 = 1;
+
+	if (options->inf_func == FUNC_FPISIN)
+	{
+		pih    = M_PI * h;
+		fpisin = 0.25 * (2 * M_PI * M_PI) * h * h;
+	}
+
+	// Open MPI lehnt manche Fenster mit einem Rang ab, ohne Nachbarn braucht es keins
+	if (options->size > 1)
+	{
+		MPI_Win_allocate(2 * (N + 1) * sizeof(double), sizeof(double), MPI_INFO_NULL, options->comm, &inbox, &window);
+
+		// bis zur ersten Zeile eines Nachbarn gelten die Anfangswerte
+		memcpy(inbox, Matrix[m2][halo_rows[DIR_UP]], (N + 1) * sizeof(double));
+		memcpy(inbox + (N + 1), Matrix[m2][halo_rows[DIR_DOWN]], (N + 1) * sizeof(double));
+
+		MPI_Win_lock_all(MPI_MODE_NOCHECK, window);
+		MPI_Barrier(options->comm);
+	}
+
+	while (true)
+	{
+		if (sweeps < options->term_iteration)
+		{
+			// neueste Zeilen der Nachbarn aus dem eigenen Fenster holen
+			start = wallTime();
+
+			for (side = 0; side < 2; side++)
+			{
+				if (neighbours[side] != MPI_PROC_NULL)
+				{
+					MPI_Get_accumulate(NULL, 0, MPI_DOUBLE, Matrix[m2][halo_rows[side]], N + 1, MPI_DOUBLE, options->rank, side * (N + 1), N + 1, MPI_DOUBLE, MPI_NO_OP, window);
+				}
+			}
+
+			if (options->size > 1)
+			{
+				MPI_Win_flush(options->rank, window);
+			}
+
+			halo_time += traceEnd(TRACE_WAIT, start) - start;
+
+			maxresiduum = 0;
+			start       = wallTime();
+
+			#pragma omp parallel for num_threads(options->number) schedule(static) reduction(max:maxresiduum)
+			for (i = 1; i < ranks - 1; i++)
+			{
+				maxresiduum = jacobiRow(Matrix[m1][i], Matrix[m2][i - 1], Matrix[m2][i], Matrix[m2][i + 1], 1, N, 0, fpisinRow(arguments, options, fpisin, pih, i), pih, 1.0, true, maxresiduum);
+			}
+
+			traceEnd(TRACE_SWEEP, start);
+
+			// eigene Randzeilen in das Fenster der Nachbarn, oben landen sie unten und umgekehrt
+			start = wallTime();
+
+			for (side = 0; side < 2; side++)
+			{
+				if (neighbours[side] != MPI_PROC_NULL)
+				{
+					MPI_Accumulate(Matrix[m1][send_rows[side]], N + 1, MPI_DOUBLE, neighbours[side], (1 - side) * (N + 1), N + 1, MPI_DOUBLE, MPI_REPLACE, window);
+					countBytes(neighbours[side], N + 1);
+				}
+			}
+
+			// die Zeilen werden in zwei Sweeps überschrieben
+			if (options->size > 1)
+			{
+				MPI_Win_flush_local_all(window);
+			}
+
+			halo_time += traceEnd(TRACE_SEND, start) - start;
+
+			/* exchange m1 and m2 */
+			i  = m1;
+			m1 = m2;
+			m2 = i;
+
+			sweeps++;
+		}
+
+		if (options->termination == TERM_ITER)
+		{
+			if (sweeps == options->term_iteration)
+			{
+				break;
+			}
+
+			continue;
+		}
+
+		// laufende Abstimmung prüfen, ohne auf die anderen zu warten
+		start = wallTime();
+
+		if (pending)
+		{
+			if (sweeps < options->term_iteration)
+			{
+				MPI_Test(&reduction, &done, MPI_STATUS_IGNORE);
+			}
+			else
+			{
+				MPI_Wait(&reduction, MPI_STATUS_IGNORE);
+				done = 1;
+			}
+
+			if (done)
+			{
+				pending = false;
+
+				if (global < options->term_precision)
+				{
+					phaseEnd(PHASE_REDUCE, start);
+					break;
+				}
+			}
+		}
+
+		if (!pending)
+		{
+			local = (sweeps < options->term_iteration) ? maxresiduum : 0.0;
+			MPI_Iallreduce(&local, &global, 1, MPI_DOUBLE, MPI_MAX, options->comm, &reduction);
+			pending = true;
+		}
+
+		phaseEnd(PHASE_REDUCE, start);
+	}
+
+	// die Abstimmung sah ältere Sweeps, ausgegeben wird das Residuum des letzten Sweeps jedes Rangs
+	start = wallTime();
+	MPI_Allreduce(&maxresiduum, &global, 1, MPI_DOUBLE, MPI_MAX, options->comm);
+	phaseEnd(PHASE_REDUCE, start);
+
+	// MPI_Win_free wartet, bis alle Ränge fertig sind
+	if (options->size > 1)
+	{
+		MPI_Win_unlock_all(window);
+		MPI_Win_free(&window);
+	}
+
+	results->stat_precision = global;
+
+	// jeder Rang hat seine eigene Anzahl an Sweeps
+	MPI_Allreduce(&sweeps, &counts[0], 1, MPI_UINT64_T, MPI_MIN, options->comm);
+	MPI_Allreduce(&sweeps, &counts[1], 1, MPI_UINT64_T, MPI_MAX, options->comm);
+
+	results->stat_iteration = counts[1];
+	results->async_sweeps[0] = counts[0];
+	results->async_sweeps[1] = counts[1];
+
+	// Zeit pro Sweep, gemittelt und als Maximum über die Ränge
+	profile.phase[PHASE_HALO] += halo_time;
+	halo_time /= sweeps;
+	MPI_Reduce(&halo_time, &results->halo_time[0], 1, MPI_DOUBLE, MPI_SUM, 0, options->comm);
+	MPI_Reduce(&halo_time, &results->halo_time[1], 1, MPI_DOUBLE, MPI_MAX, 0, options->comm);
+	results->halo_time[0] /= options->size;
+
+	results->m = m2;
+}
+
+/* ************************************************************************ */
+/* calculate: solves the equation for Jacobi with options->tiles tiles per  */
+/*            rank (overdecomposition)                                      */
+/*                                                                          */
+/* The own rows are split into row blocks (tiles) that the threads take     */
+/* from a small scheduler. A tile is runnable when the halo rows it reads   */
+/* have arrived; the first and the last tile come first, so their new rows */
+/* are sent while the inner tiles are still being computed. Only the master */
+/* thread calls MPI (MPI_THREAD_FUNNELED): it polls the receives between    */
+/* its tiles and posts the sends of the tiles finished by other threads.    */
+/* The halos for the next iteration are received into the new matrix, they  */
+/* are posted at the start of the iteration.                                */
+/* ************************************************************************ */
+static void
+MPI_jacobi_tiles(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
+{
+	MPI_Request receive[2][2] = { { MPI_REQUEST_NULL, MPI_REQUEST_NULL }, { MPI_REQUEST_NULL, MPI_REQUEST_NULL } };
+	MPI_Request send[2]       = { MPI_REQUEST_NULL, MPI_REQUEST_NULL };
+
+	struct convergence convergence = { .started = 0 };
+
+	int    i, t, side;  /* local variables for loops */
+	int    m1, m2;      /* used as indices for old and new matrices */
+	double maxresiduum; /* maximum residuum value of a slave in iteration */
+
+	int const    N     = arguments->N;
+	int const    ranks = arguments->ranks;
+	double const h     = arguments->h;
+
+	int const neighbours[2] = {
+		(options->rank > 0) ? options->rank - 1 : MPI_PROC_NULL,
+		(options->rank < options->size - 1) ? options->rank + 1 : MPI_PROC_NULL
+	};
+
+	// nicht mehr Kacheln als eigene Zeilen
+	int const tiles = (options->tiles < ranks - 2) ? options->tiles : ranks - 2;
+
+	// Zeilen first[t] .. first[t + 1] - 1, Kacheln mit Nachbarrang zuerst
+	int first[tiles + 1];
+	int order[tiles];
+	int length, count;
+
+	// 0: wartet auf Halos, 1: ausführbar, 2: vergeben, 3: fertig
+	atomic_int state[tiles];
+	atomic_int finished;
+	atomic_int send_ready[2];
+
+	uint64_t const first_iteration = results->stat_iteration;
+
+	double pih    = 0.0;
+	double fpisin = 0.0;
+	double omega  = 1.0;
+	double halo_time = 0.0;
+	double start;
+
+	int term_iteration = options->term_iteration;
+
+	typedef double(*matrix)[ranks][N + 1];
+
+	matrix Matrix = (matrix)arguments->M;
+
+	m1 = 0;
+	m2 = 1;
+
+	if (options->inf_func == FUNC_FPISIN)
+	{
+		pih    = M_PI * h;
+		fpisin = 0.25 * (2 * M_PI * M_PI) * h * h;
+	}
+
+	for (t = 0; t < tiles; t++)
+	{
+		distribute(ranks - 2, tiles, t, &first[t], &length);
+		first[t] += 1;
+	}
+
+	first[tiles] = ranks - 1;
+
+	count = 0;
+	order[count++] = 0;
+
+	if (tiles > 1)
+	{
+		order[count++] = tiles - 1;
+	}
+
+	for (t = 1; t < tiles - 1; t++)
+	{
+		order[count++] = t;
+	}
+
+	while (term_iteration > 0)
+	{
+		// Halos der nächsten Iteration landen in der neuen Matrix, die hier nur geschrieben wird
+		start = wallTime();
+		MPI_Irecv(Matrix[m1][0], N + 1, MPI_DOUBLE, neighbours[DIR_UP], 0, options->comm, &receive[m1][DIR_UP]);
+		MPI_Irecv(Matrix[m1][ranks - 1], N + 1, MPI_DOUBLE, neighbours[DIR_DOWN], 0, options->comm, &receive[m1][DIR_DOWN]);
+		halo_time += traceEnd(TRACE_SEND, start) - start;
+
+		for (t = 0; t < tiles; t++)
+		{
+			bool const upper = (t == 0 && receive[m2][DIR_UP] != MPI_REQUEST_NULL);
+			bool const lower = (t == tiles - 1 && receive[m2][DIR_DOWN] != MPI_REQUEST_NULL);
+
+			atomic_init(&state[t], (upper || lower) ? 0 : 1);
+		}
+
+		atomic_init(&finished, 0);
+		atomic_init(&send_ready[DIR_UP], 0);
+		atomic_init(&send_ready[DIR_DOWN], 0);
+
+		maxresiduum = 0;
+
+		#pragma omp parallel num_threads(options->number) private(t, i, side) reduction(max:maxresiduum)
+		{
+			bool const residual = (options->termination == TERM_PREC || term_iteration == 1);
+			bool const master   = (omp_get_thread_num() == 0);
+
+			int  expected, tile, flag;
+			bool up_done, down_done;
+			bool sent[2] = { false, false };
+
+			while (true)
+			{
+				if (master)
+				{
+					double const poll = wallTime();
+
+					// angekommene Halos machen die Randkacheln ausführbar
+					for (side = 0; side < 2; side++)
+					{
+						if (receive[m2][side] != MPI_REQUEST_NULL)
+						{
+							MPI_Test(&receive[m2][side], &flag, MPI_STATUS_IGNORE);
+						}
+					}
+
+					up_done   = (receive[m2][DIR_UP] == MPI_REQUEST_NULL);
+					down_done = (receive[m2][DIR_DOWN] == MPI_REQUEST_NULL);
+
+					if (up_done && (tiles > 1 || down_done))
+					{
+						expected = 0;
+						atomic_compare_exchange_strong(&state[0], &expected, 1);
+					}
+
+					if (down_done && (tiles > 1 || up_done))
+					{
+						expected = 0;
+						atomic_compare_exchange_strong(&state[tiles - 1], &expected, 1);
+					}
+
+					// fertige Randzeilen sofort verschicken, auch wenn ein anderer Thread sie berechnet hat
+					for (side = 0; side < 2; side++)
+					{
+						if (!sent[side] && atomic_load(&send_ready[side]))
+						{
+							MPI_Isend(Matrix[m1][(side == DIR_UP) ? 1 : ranks - 2], N + 1, MPI_DOUBLE, neighbours[side], 0, options->comm, &send[side]);
+							countBytes(neighbours[side], N + 1);
+							sent[side] = true;
+						}
+					}
+
+					halo_time += wallTime() - poll;
+
+					if (atomic_load(&finished) == tiles && sent[DIR_UP] && sent[DIR_DOWN])
+					{
+						break;
+					}
+				}
+				else if (atomic_load(&finished) == tiles)
+				{
+					break;
+				}
+
+				// erste ausführbare Kachel nach Priorität nehmen
+				tile = -1;
+
+				for (t = 0; t < tiles && tile < 0; t++)
+				{
+					expected = 1;
+
+					if (atomic_compare_exchange_strong(&state[order[t]], &expected, 2))
+					{
+						tile = order[t];
+					}
+				}
+
+				if (tile < 0)
+				{
+					sched_yield();
+					continue;
+				}
+
+				double const begin = wallTime();
+
+				for (i = first[tile]; i < first[tile + 1]; i++)
+				{
+					maxresiduum = jacobiRow(Matrix[m1][i], Matrix[m2][i - 1], Matrix[m2][i], Matrix[m2][i + 1], 1, N, 0, fpisinRow(arguments, options, fpisin, pih, i), pih, omega, residual, maxresiduum);
+				}
+
+				traceEnd(TRACE_SWEEP, begin);
+				atomic_store(&state[tile], 3);
+
+				if (tile == 0)
+				{
+					atomic_store(&send_ready[DIR_UP], 1);
+				}
+
+				if (tile == tiles - 1)
+				{
+					atomic_store(&send_ready[DIR_DOWN], 1);
+				}
+
+				atomic_fetch_add(&finished, 1);
+			}
+		}
+
+		// die Randzeilen werden in zwei Iterationen wieder überschrieben
+		start = wallTime();
+		MPI_Waitall(2, send, MPI_STATUSES_IGNORE);
+		halo_time += traceEnd(TRACE_WAIT, start) - start;
+
+		/* exchange m1 and m2 */
+		i  = m1;
+		m1 = m2;
+		m2 = i;
+
+		/* check for stopping calculation depending on termination method */
+		term_iteration = checkTermination(&convergence, maxresiduum, term_iteration, options->comm, results, options);
+
+		omega = chebyshevOmega(options, cos(M_PI * h), omega, results->stat_iteration - first_iteration);
+	}
+
+	// die Halos der nicht mehr gerechneten Iteration abholen
+	MPI_Waitall(2, receive[m2], MPI_STATUSES_IGNORE);
+
+	// Zeit pro Iteration, gemittelt und als Maximum über die Ränge
+	profile.phase[PHASE_HALO] += halo_time;
+	halo_time /= results->stat_iteration - first_iteration;
+	MPI_Reduce(&halo_time, &results->halo_time[0], 1, MPI_DOUBLE, MPI_SUM, 0, options->comm);
+	MPI_Reduce(&halo_time, &results->halo_time[1], 1, MPI_DOUBLE, MPI_MAX, 0, options->comm);
+	results->halo_time[0] /= options->size;
+
+	results->m = m2;
+}
+
+/* ************************************************************************ */
+/* calculate: solves the equation for Jacobi with the 2D decomposition      */
+/*                                                                          */
+/* Like MPI_jacobi_calculate, but every rank owns a block of rows and       */
+/* columns. The outer ring of the block is computed first, then the halos   */
+/* are exchanged while the inner points are computed. Column halos are sent */
+/* directly from the matrix with a strided MPI_Type_vector.                 */
+/* ************************************************************************ */
+static void
+MPI_jacobi_calculate_cart(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
+{
+	MPI_Request requests[8];
+	int num_requests;
+
+	struct convergence convergence = { .started = 0 };
+
+	int    i;           /* local variables for loops */
+	int    m1, m2;      /* used as indices for old and new matrices */
+	double maxresiduum; /* maximum residuum value of a slave in iteration */
+	double start;       /* beginning of the current phase */
+
+	int const    rows = arguments->ranks;
+	int const    cols = arguments->cols;
+	double const h    = arguments->h;
+
+	int const* neighbours = arguments->neighbours;
+	MPI_Comm const comm   = arguments->comm;
+
+	MPI_Datatype column;
+
+	double pih    = 0.0;
+	double fpisin = 0.0;
+	double omega  = 1.0;
+
+	uint64_t const first_iteration = results->stat_iteration;
+
+	int term_iteration = options->term_iteration;
+
+	typedef double(*matrix)[rows][cols];
+
+	matrix Matrix = (matrix)arguments->M;
+
+	m1 = 0;
+	m2 = 1;
+
+	if (options->inf_func == FUNC_FPISIN)
+	{
+		pih    = M_PI * h;
+		fpisin = 0.25 * (2 * M_PI * M_PI) * h * h;
+	}
+
+	// eine Spalte ohne die Halo-Zeilen, aufeinanderfolgende Werte liegen cols Elemente auseinander
+	MPI_Type_vector(rows - 2, 1, cols, MPI_DOUBLE, &column);
+	MPI_Type_commit(&column);
+
+	while (term_iteration > 0)
+	{
+		bool const residual = (options->termination == TERM_PREC || term_iteration == 1);
+
+		maxresiduum = 0;
+		num_requests = 0;
+		start = wallTime();
+
+		// Zuerst den äußeren Ring berechnen: erste und letzte Zeile ...
+		maxresiduum = jacobiRow(Matrix[m1][1], Matrix[m2][0], Matrix[m2][1], Matrix[m2][2], 1, cols - 1, arguments->col_start, fpisinRow(arguments, options, fpisin, pih, 1), pih, omega, residual, maxresiduum);
+
+		if (rows - 2 > 1)
+		{
+			maxresiduum = jacobiRow(Matrix[m1][rows - 2], Matrix[m2][rows - 3], Matrix[m2][rows - 2], Matrix[m2][rows - 1], 1, cols - 1, arguments->col_start, fpisinRow(arguments, options, fpisin, pih, rows - 2), pih, omega, residual, maxresiduum);
+		}
+
+		// ... dann erste und letzte Spalte der übrigen Zeilen
+		for (i = 2; i < rows - 2; i++)
+		{
+			double const fpisin_i = fpisinRow(arguments, options, fpisin, pih, i);
+
+			maxresiduum = jacobiRow(Matrix[m1][i], Matrix[m2][i - 1], Matrix[m2][i], Matrix[m2][i + 1], 1, 2, arguments->col_start, fpisin_i, pih, omega, residual, maxresiduum);
+
+			if (cols - 2 > 1)
+			{
+				maxresiduum = jacobiRow(Matrix[m1][i], Matrix[m2][i - 1], Matrix[m2][i], Matrix[m2][i + 1], cols - 2, cols - 1, arguments->col_start, fpisin_i, pih, omega, residual, maxresiduum);
+			}
+		}
+
+		// Halos austauschen, der Tag ist die Richtung, in die die Nachricht läuft
+		// an den Rändern ist der Nachbar MPI_PROC_NULL und es passiert nichts
+		start = phaseEnd(PHASE_COMPUTE, start);
+
+		MPI_Isend(&Matrix[m1][1][1], cols - 2, MPI_DOUBLE, neighbours[DIR_UP], DIR_UP, comm, &requests[num_requests++]);
+		MPI_Isend(&Matrix[m1][rows - 2][1], cols - 2, MPI_DOUBLE, neighbours[DIR_DOWN], DIR_DOWN, comm, &requests[num_requests++]);
+		MPI_Isend(&Matrix[m1][1][1], 1, column, neighbours[DIR_LEFT], DIR_LEFT, comm, &requests[num_requests++]);
+		MPI_Isend(&Matrix[m1][1][cols - 2], 1, column, neighbours[DIR_RIGHT], DIR_RIGHT, comm, &requests[num_requests++]);
+
+		MPI_Irecv(&Matrix[m1][0][1], cols - 2, MPI_DOUBLE, neighbours[DIR_UP], DIR_DOWN, comm, &requests[num_requests++]);
+		MPI_Irecv(&Matrix[m1][rows - 1][1], cols - 2, MPI_DOUBLE, neighbours[DIR_DOWN], DIR_UP, comm, &requests[num_requests++]);
+		MPI_Irecv(&Matrix[m1][1][0], 1, column, neighbours[DIR_LEFT], DIR_RIGHT, comm, &requests[num_requests++]);
+		MPI_Irecv(&Matrix[m1][1][cols - 1], 1, column, neighbours[DIR_RIGHT], DIR_LEFT, comm, &requests[num_requests++]);
+
+		countBytes(neighbours[DIR_UP], cols - 2);
+		countBytes(neighbours[DIR_DOWN], cols - 2);
+		countBytes(neighbours[DIR_LEFT], rows - 2);
+		countBytes(neighbours[DIR_RIGHT], rows - 2);
+
+		start = phaseEvent(PHASE_HALO, TRACE_SEND, start);
+
+		/* over all inner points */
+		for (i = 2; i < rows - 2; i++)
+		{
+			maxresiduum = jacobiRow(Matrix[m1][i], Matrix[m2][i - 1], Matrix[m2][i], Matrix[m2][i + 1], 2, cols - 2, arguments->col_start, fpisinRow(arguments, options, fpisin, pih, i), pih, omega, residual, maxresiduum);
+		}
+
+		// Warten bis alles da ist
+		start = phaseEnd(PHASE_COMPUTE, start);
+		MPI_Waitall(num_requests, requests, MPI_STATUSES_IGNORE);
+		phaseEnd(PHASE_HALO, start);
+
+		/* exchange m1 and m2 */
+		i  = m1;
+		m1 = m2;
+		m2 = i;
+
+		/* check for stopping calculation depending on termination method */
+		term_iteration = checkTermination(&convergence, maxresiduum, term_iteration, comm, results, options);
+
+		omega = chebyshevOmega(options, cos(M_PI * h), omega, results->stat_iteration - first_iteration);
+	}
+
+	MPI_Type_free(&column);
+
+	results->m = m2;
+}
+
+/* ************************************************************************ */
+/* gaussSeidelBlocks: default number of column blocks of the pipeline       */
+/*                                                                          */
+/* A rank can start once the first block of its upper neighbour is done,    */
+/* so the pipeline fills after size blocks instead of size strips. Four     */
+/* blocks per rank keep the fill short while the messages stay long enough. */
+/* ************************************************************************ */
+static int
+gaussSeidelBlocks(int N, int size)
+{
+	if (size <= 1)
+	{
+		return 1;
+	}
+
+	return (4 * size < N - 1) ? 4 * size : N - 1;
+}
+
+/* ************************************************************************ */
+/* block: columns first .. last - 1 of block b of the inner columns         */
+/* ************************************************************************ */
+static void
+block(int N, int blocks, int b, int* first, int* last)
+{
+	int length;
+
+	distribute(N - 1, blocks, b, first, &length);
+
+	*first += 1;
+	*last   = *first + length;
+}
+
+/* ************************************************************************ */
+/* gaussSeidelRow: computes columns first .. last - 1 of one row in place   */
+/* omega is the SOR weight (1: Gauß-Seidel), the residuum is not weighted   */
+/* returns the maximum of maxresiduum and the residua of the row            */
+/* ************************************************************************ */
+static double
+gaussSeidelRow(double* row, double const* up, double const* down, int first, int last, double fpisin_i, double pih, double omega, double maxresiduum)
+{
+	int    j;
+	double star;
+	double residuum;
+
+	/* over all columns */
+	for (j = first; j < last; j++)
+	{
+		star     = row[j] - (0.25 * (up[j] + row[j - 1] + row[j + 1] + down[j]));
+		residuum = -star;
+
+		if (fpisin_i != 0.0)
+		{
+			residuum = (fpisin_i * sin(pih * (double)j)) - star;
+		}
+
+		row[j]      = row[j] + omega * residuum;
+		residuum    = fabs(residuum);
+		maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+	}
+
+	return maxresiduum;
+}
+
+/* ************************************************************************ */
+/* calculate: solves the equation with Gauss-Seidel                         */
+/*                                                                          */
+/* The ranks form a pipeline. The inner columns are split into blocks and   */
+/* every block is computed over all rows of the strip before the next one.  */
+/* The finished part of the boundary rows is sent right away, so the next   */
+/* rank can start after one block of its upper neighbour.                   */
+/* ************************************************************************ */
+static void
+MPI_Gauss_Seidel_calculate(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
+{
+	int    i, b;        /* local variables for loops */
+	int    m1, m2;      /* used as indices for old and new matrices */
+	int    first, last; /* columns of a block */
+	double maxresiduum; /* maximum residuum value of a slave in iteration */
+	double start;       /* beginning of the current phase */
+
+	struct convergence convergence = { .started = 0 };
+
+	int const    N = arguments->N;
+	int const    ranks = arguments->ranks;
+	double const h = arguments->h;
+
+	// Nachbarn, am Rand MPI_PROC_NULL
+	int const upper = (options->rank > 0) ? options->rank - 1 : MPI_PROC_NULL;
+	int const lower = (options->rank < options->size - 1) ? options->rank + 1 : MPI_PROC_NULL;
+
+	// Spaltenblöcke der Pipeline und Requests je Block
+	int const blocks = (options->gs_blocks > 0) ? options->gs_blocks : gaussSeidelBlocks(N, options->size);
+
+	MPI_Request receive[2][blocks];
+	MPI_Request send[2][blocks];
+
+	double fpisin_i[ranks];
+
+	double pih    = 0.0;
+	double fpisin = 0.0;
+
+	int term_iteration = options->term_iteration;
+	bool first_iteration = true;
+
+	typedef double(*matrix)[arguments->ranks][N + 1];
+
+	matrix Matrix = (matrix)arguments->M;
+
+	/* Gauß-Seidel rechnet in place auf einer Matrix */
+	m1 = 0;
+	m2 = 0;
+
+	if (options->inf_func == FUNC_FPISIN)
+	{
+		pih    = M_PI * h;
+		fpisin = 0.25 * (2 * M_PI * M_PI) * h * h;
+	}
+
+	for (i = 0; i < ranks; i++)
+	{
+		fpisin_i[i] = fpisinRow(arguments, options, fpisin, pih, i);
+	}
+
+	for (b = 0; b < blocks; b++)
+	{
+		send[0][b] = MPI_REQUEST_NULL;
+		send[1][b] = MPI_REQUEST_NULL;
+	}
+
+	while (term_iteration > 0)
+	{
+		maxresiduum = 0;
+
+		start = wallTime();
+
+		/* Halo-Zeilen blockweise vorab empfangen: oben die Zeile des vorherigen Rangs */
+		/* aus dieser Iteration, unten die des nächsten Rangs aus der letzten         */
+		for (b = 0; b < blocks; b++)
+		{
+			block(N, blocks, b, &first, &last);
+
+			MPI_Irecv(&Matrix[m1][0][first], last - first, MPI_DOUBLE, upper, 422, options->comm, &receive[0][b]);
+			MPI_Irecv(&Matrix[m1][ranks - 1][first], last - first, MPI_DOUBLE, first_iteration ? MPI_PROC_NULL : lower, 421, options->comm, &receive[1][b]);
+		}
+
+		/* Randzeilen der letzten Iteration müssen verschickt sein, bevor sie überschrieben */
+		/* werden; erst hier warten, damit der Abbruch-Handshake nicht blockiert           */
+		MPI_Waitall(blocks, send[0], MPI_STATUSES_IGNORE);
+		MPI_Waitall(blocks, send[1], MPI_STATUSES_IGNORE);
+
+		/* Spaltenblöcke nacheinander über alle Zeilen: jeder Punkt sieht dieselben */
+		/* alten und neuen Nachbarn wie bei zeilenweiser Reihenfolge                */
+		for (b = 0; b < blocks; b++)
+		{
+			block(N, blocks, b, &first, &last);
+
+			MPI_Wait(&receive[0][b], MPI_STATUS_IGNORE);
+			MPI_Wait(&receive[1][b], MPI_STATUS_IGNORE);
+
+			start = phaseEnd(PHASE_HALO, start);
+
+			/* over all rows */
+			for (i = 1; i < ranks - 1; i++)
+			{
+				maxresiduum = gaussSeidelRow(Matrix[m1][i], Matrix[m1][i - 1], Matrix[m1][i + 1], first, last, fpisin_i[i], pih, 1.0, maxresiduum);
+			}
+
+			start = phaseEnd(PHASE_COMPUTE, start);
+
+			/* Blöcke der Randzeilen sofort weitergeben, damit die Nachbarn anfangen können */
+			MPI_Isend(&Matrix[m1][1][first], last - first, MPI_DOUBLE, upper, 421, options->comm, &send[0][b]);
+			MPI_Isend(&Matrix[m1][ranks - 2][first], last - first, MPI_DOUBLE, lower, 422, options->comm, &send[1][b]);
+			countBytes(upper, last - first);
+			countBytes(lower, last - first);
+
+			start = phaseEvent(PHASE_HALO, TRACE_SEND, start);
+		}
+
+		phaseEnd(PHASE_HALO, start);
+
+		/* exchange m1 and m2 */
+		i  = m1;
+		m1 = m2;
+		m2 = i;
+
+		/* alle Ränge entscheiden gemeinsam mit einer nicht-blockierenden Reduktion, */
+		/* die Pipeline läuft währenddessen weiter                                  */
+		term_iteration = checkTermination(&convergence, maxresiduum, term_iteration, options->comm, results, options);
+
+		first_iteration = false;
+	}
+
+	/* die Randzeile des nächsten Rangs aus der letzten Iteration abholen */
+	start = wallTime();
+
+	for (b = 0; b < blocks; b++)
+	{
+		block(N, blocks, b, &first, &last);
+		MPI_Irecv(&Matrix[m2][ranks - 1][first], last - first, MPI_DOUBLE, lower, 421, options->comm, &receive[1][b]);
+	}
+
+	MPI_Waitall(blocks, send[0], MPI_STATUSES_IGNORE);
+	MPI_Waitall(blocks, send[1], MPI_STATUSES_IGNORE);
+	MPI_Waitall(blocks, receive[1], MPI_STATUSES_IGNORE);
+
+	phaseEnd(PHASE_HALO, start);
+
+	results->m = m2;
+}
+
+/* ************************************************************************ */
+/* cgOperatorRow: applies the scaled five-point operator to one inner row   */
+/*                                                                          */
+/* A = I - 1/4 (sum of the four neighbours), so b - A x is exactly the      */
+/* change of one Jacobi step. Columns 0 and N of the vectors stay zero.     */
+/* ************************************************************************ */
+static void
+cgOperatorRow(double* restrict out, double const* up, double const* row, double const* down, int N)
+{
+	int j;
+
+	for (j = 1; j < N; j++)
+	{
+		out[j] = row[j] - 0.25 * (up[j] + row[j - 1] + row[j + 1] + down[j]);
+	}
+}
+
+/* ************************************************************************ */
+/* cgPrecondition: out = M^-1 in on the inner rows 1 .. ranks - 2           */
+/*                                                                          */
+/* PRECOND_JACOBI: the diagonal of A is 1, so M^-1 is the identity.         */
+/* PRECOND_SSOR: one forward and one backward Gauß-Seidel sweep with weight */
+/* omega over the strip of this rank, rows of other ranks count as zero.    */
+/* M is then block diagonal and symmetric, needs no communication and      */
+/* keeps CG applicable. The sweeps run on one thread.                       */
+/* ************************************************************************ */
+static void
+cgPrecondition(double* restrict out, double const* in, int ranks, int N, struct options const* options)
+{
+	typedef double(*vector)[N + 1];
+
+	vector Out = (vector)out;
+
+	double const(*In)[N + 1] = (double const(*)[N + 1])in;
+
+	double const omega = options->ssor_omega;
+	double const scale = omega * (2.0 - omega);
+
+	int i, j;
+
+	if (options->precond == PRECOND_JACOBI)
+	{
+		#pragma omp parallel for num_threads(options->number) schedule(static)
+		for (i = 1; i < ranks - 1; i++)
+		{
+			memcpy(&Out[i][1], &In[i][1], (N - 1) * sizeof(double));
+		}
+
+		return;
+	}
+
+	/* vorwärts: (D + omega L) y = omega (2 - omega) in */
+	for (i = 1; i < ranks - 1; i++)
+	{
+		for (j = 1; j < N; j++)
+		{
+			Out[i][j] = scale * In[i][j] + 0.25 * omega * (Out[i][j - 1] + ((i > 1) ? Out[i - 1][j] : 0.0));
+		}
+	}
+
+	/* rückwärts: (D + omega U) out = D y */
+	for (i = ranks - 2; i > 0; i--)
+	{
+		for (j = N - 1; j > 0; j--)
+		{
+			Out[i][j] += 0.25 * omega * (Out[i][j + 1] + ((i < ranks - 2) ? Out[i + 1][j] : 0.0));
+		}
+	}
+}
+
+/* ************************************************************************ */
+/* cgReduce: MPI_Op of the fused reduction of the pipelined CG              */
+/* adds the two inner products and takes the maximum of the residual norm   */
+/* ************************************************************************ */
+static void
+cgReduce(void* in, void* inout, int* len, MPI_Datatype* type)
+{
+	double const* a = in;
+	double*       b = inout;
+	int           i;
+
+	(void)type;
+
+	for (i = 0; i < *len; i++, a += 3, b += 3)
+	{
+		b[0] += a[0];
+		b[1] += a[1];
+		b[2] = (a[2] < b[2]) ? b[2] : a[2];
+	}
+}
+
+/* ************************************************************************ */
+/* MPI_cg_calculate: solves the equation with pipelined preconditioned CG   */
+/*                                                                          */
+/* Same strips and halo exchange as MPI_jacobi_calculate, the solution is   */
+/* kept in the only matrix. In the variant of Ghysels and Vanroose both     */
+/* inner products of an iteration are known at its start, so they are      */
+/* reduced together with the maximum norm of the residual in one            */
+/* MPI_Iallreduce. It runs while M^-1 w and A M^-1 w (with the halo         */
+/* exchange of M^-1 w) are computed.                                        */
+/*                                                                          */
+/* The residual r = b - A x is the change of one Jacobi step, so TERM_PREC  */
+/* uses the same criterion as Jacobi. r comes from the recurrence and is    */
+/* not recomputed.                                                          */
+/* ************************************************************************ */
+static void
+MPI_cg_calculate(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
+{
+	int const      N     = arguments->N;
+	int const      ranks = arguments->ranks;
+	double const   h     = arguments->h;
+	uint64_t const size  = (uint64_t)ranks * (N + 1);
+
+	typedef double(*vector)[N + 1];
+
+	// zuerst zweimal m: nur über diesen Vektor läuft der Halo-Austausch, abwechselnd
+	// in beiden Kopien wie bei den zwei Jacobi-Matrizen (sonst überschreibt MPI_Put
+	// die Halo-Zeile eines Nachbarn, bevor er sie gelesen hat)
+	double* vectors = allocateMemory(10 * size * sizeof(double));
+
+	vector X  = (vector)arguments->M;
+	vector Mv = (vector)(vectors);
+	vector R  = (vector)(vectors + 2 * size);
+	vector U  = (vector)(vectors + 3 * size);
+	vector W  = (vector)(vectors + 4 * size);
+	vector Nv = (vector)(vectors + 5 * size);
+	vector Z  = (vector)(vectors + 6 * size);
+	vector Q  = (vector)(vectors + 7 * size);
+	vector S  = (vector)(vectors + 8 * size);
+	vector P  = (vector)(vectors + 9 * size);
+
+	// Halo-Austausch wie bei Jacobi, aber auf m statt auf der Matrix
+	struct calculation_arguments halo_arguments = *arguments;
+	struct halo halo;
+	uint64_t exchanges = 0;
+	int      slot;
+	double   halo_time;
+	double   start;
+
+	// gamma = (r, u), delta = (w, u) und max |r| in einer Reduktion
+	double       local[3], global[3];
+	MPI_Request  reduction;
+	MPI_Datatype triple;
+	MPI_Op       op;
+
+	double alpha = 0.0, beta = 0.0, gamma_old = 0.0;
+	double gamma, delta, norm;
+
+	double pih    = 0.0;
+	double fpisin = 0.0;
+
+	int i, j;
+
+	if (options->inf_func == FUNC_FPISIN)
+	{
+		pih    = M_PI * h;
+		fpisin = 0.25 * (2 * M_PI * M_PI) * h * h;
+	}
+
+	memset(vectors, 0, 10 * size * sizeof(double));
+
+	halo_arguments.M            = vectors;
+	halo_arguments.num_matrices = 2;
+	haloInit(&halo, &halo_arguments, options);
+
+	MPI_Type_contiguous(3, MPI_DOUBLE, &triple);
+	MPI_Type_commit(&triple);
+	MPI_Op_create(cgReduce, 1, &op);
+
+	// r = b - A x, die Halo-Zeilen von x sind noch die Anfangswerte
+	#pragma omp parallel for num_threads(options->number) schedule(static) private(j)
+	for (i = 1; i < ranks - 1; i++)
+	{
+		jacobiRow(R[i], X[i - 1], X[i], X[i + 1], 1, N, 0, fpisinRow(arguments, options, fpisin, pih, i), pih, 1.0, false, 0.0);
+
+		for (j = 1; j < N; j++)
+		{
+			R[i][j] -= X[i][j];
+		}
+	}
+
+	// u = M^-1 r, w = A u
+	cgPrecondition(Mv[0], R[0], ranks, N, options);
+	haloStart(&halo, &halo_arguments, 0);
+	haloWait(&halo, exchanges++);
+
+	#pragma omp parallel for num_threads(options->number) schedule(static)
+	for (i = 1; i < ranks - 1; i++)
+	{
+		cgOperatorRow(W[i], Mv[i - 1], Mv[i], Mv[i + 1], N);
+	}
+
+	memcpy(U, Mv, size * sizeof(double));
+
+	gamma = 0.0;
+	delta = 0.0;
+	norm  = 0.0;
+
+	#pragma omp parallel for num_threads(options->number) schedule(static) private(j) reduction(+:gamma,delta) reduction(max:norm)
+	for (i = 1; i < ranks - 1; i++)
+	{
+		for (j = 1; j < N; j++)
+		{
+			gamma += R[i][j] * U[i][j];
+			delta += W[i][j] * U[i][j];
+			norm   = (fabs(R[i][j]) < norm) ? norm : fabs(R[i][j]);
+		}
+	}
+
+	local[0] = gamma;
+	local[1] = delta;
+	local[2] = norm;
+	MPI_Iallreduce(local, global, 1, triple, op, options->comm, &reduction);
+
+	while (true)
+	{
+		if (results->stat_iteration == options->term_iteration)
+		{
+			MPI_Wait(&reduction, MPI_STATUS_IGNORE);
+			break;
+		}
+
+		// m = M^-1 w und n = A m, während die Skalarprodukte reduziert werden
+		slot = exchanges % 2;
+		Mv   = (vector)(vectors + slot * size);
+
+		cgPrecondition(Mv[0], W[0], ranks, N, options);
+		haloStart(&halo, &halo_arguments, slot);
+
+		#pragma omp parallel for num_threads(options->number) schedule(static)
+		for (i = 2; i < ranks - 2; i++)
+		{
+			cgOperatorRow(Nv[i], Mv[i - 1], Mv[i], Mv[i + 1], N);
+		}
+
+		haloWait(&halo, exchanges++);
+
+		cgOperatorRow(Nv[1], Mv[0], Mv[1], Mv[2], N);
+
+		if (ranks - 2 > 1)
+		{
+			cgOperatorRow(Nv[ranks - 2], Mv[ranks - 3], Mv[ranks - 2], Mv[ranks - 1], N);
+		}
+
+		start = wallTime();
+		MPI_Wait(&reduction, MPI_STATUS_IGNORE);
+		phaseEnd(PHASE_REDUCE, start);
+
+		gamma = global[0];
+		delta = global[1];
+
+		// gamma = 0: r ist schon exakt null
+		if ((options->termination == TERM_PREC && global[2] < options->term_precision) || gamma <= 0.0)
+		{
+			break;
+		}
+
+		if (results->stat_iteration > 0)
+		{
+			beta  = gamma / gamma_old;
+			alpha = gamma / (delta - beta * gamma / alpha);
+		}
+		else
+		{
+			beta  = 0.0;
+			alpha = gamma / delta;
+		}
+
+		gamma_old = gamma;
+
+		gamma = 0.0;
+		delta = 0.0;
+		norm  = 0.0;
+
+		// alle Rekursionen in einem Durchlauf, dabei schon die Skalarprodukte der nächsten Iteration
+		#pragma omp parallel for num_threads(options->number) schedule(static) private(j) reduction(+:gamma,delta) reduction(max:norm)
+		for (i = 1; i < ranks - 1; i++)
+		{
+			for (j = 1; j < N; j++)
+			{
+				Z[i][j] = Nv[i][j] + beta * Z[i][j];
+				Q[i][j] = Mv[i][j] + beta * Q[i][j];
+				S[i][j] = W[i][j] + beta * S[i][j];
+				P[i][j] = U[i][j] + beta * P[i][j];
+
+				X[i][j] += alpha * P[i][j];
+				R[i][j] -= alpha * S[i][j];
+				U[i][j] -= alpha * Q[i][j];
+				W[i][j] -= alpha * Z[i][j];
+
+				gamma += R[i][j] * U[i][j];
+				delta += W[i][j] * U[i][j];
+				norm   = (fabs(R[i][j]) < norm) ? norm : fabs(R[i][j]);
+			}
+		}
+
+		local[0] = gamma;
+		local[1] = delta;
+		local[2] = norm;
+		MPI_Iallreduce(local, global, 1, triple, op, options->comm, &reduction);
+
+		results->stat_iteration++;
+	}
+
+	results->stat_precision = global[2];
+
+	haloFree(&halo, &halo_arguments);
+	MPI_Op_free(&op);
+	MPI_Type_free(&triple);
+	free(vectors);
+
+	// Zeit pro Austausch, gemittelt und als Maximum über die Ränge
+	halo_time = halo.time / exchanges;
+	MPI_Reduce(&halo_time, &results->halo_time[0], 1, MPI_DOUBLE, MPI_SUM, 0, options->comm);
+	MPI_Reduce(&halo_time, &results->halo_time[1], 1, MPI_DOUBLE, MPI_MAX, 0, options->comm);
+	results->halo_time[0] /= options->size;
+
+	results->m = 0;
+}
+
+/* ************************************************************************ */
+/* mgCoarseRange: coarse rows first .. last - 1 whose fine row 2 I belongs  */
+/*                to rank q of the finer level (for odd N the last coarse   */
+/*                row belongs to the rank of the last fine row)             */
+/* ************************************************************************ */
+static void
+mgCoarseRange(struct level const* fine, int q, int* first, int* last)
+{
+	*first = (fine->starts[q] + 1) / 2;
+	*last  = (q + 1 == fine->active) ? (fine->N + 1) / 2 + 1 : (fine->starts[q + 1] + 1) / 2;
+}
+
+/* ************************************************************************ */
+/* mgStageRange: coarse rows first .. last - 1 that rank q of the finer     */
+/* level keeps in the stage of a gathered level: its restricted rows on the */
+/* way down, the rows needed for the interpolation on the way up            */
+/* ************************************************************************ */
+static void
+mgStageRange(struct level const* fine, int q, bool down, int* first, int* last)
+{
+	if (down)
+	{
+		mgCoarseRange(fine, q, first, last);
+	}
+	else
+	{
+		// bei ungeradem N reicht die Interpolation eine grobe Zeile weiter
+		*first = fine->starts[q] / 2;
+		*last  = (fine->starts[q + 1] + fine->N % 2) / 2 + 1;
+	}
+}
+
+/* ************************************************************************ */
+/* mgInit: builds the levels of the multigrid hierarchy                     */
+/*                                                                          */
+/* Level 0 is the strip decomposition of the matrix. A coarse row I first   */
+/* stays with the rank of fine row 2 I, so restriction and interpolation    */
+/* only need the usual halo rows. Once a rank would keep fewer than         */
+/* MG_MIN_ROWS rows, the level is gathered onto fewer ranks (agglomeration) */
+/* and the others idle until the correction comes back. An odd N is         */
+/* coarsened to (N + 1) / 2 (see mgRestrict), so the hierarchy always ends  */
+/* at N = 2, which is gathered onto rank 0.                                 */
+/* returns the number of levels                                             */
+/* ************************************************************************ */
+static int
+mgInit(struct level* levels, struct calculation_arguments const* arguments, struct options const* options)
+{
+	int const rank = options->rank;
+
+	struct level* fine;
+	struct level* coarse;
+
+	int l, q, first, last, length, fewest, active, count;
+	bool coarsest;
+
+	levels[0].N         = arguments->N;
+	levels[0].active    = options->size;
+	levels[0].gathered  = false;
+	levels[0].comm      = options->comm;
+	levels[0].row_start = arguments->row_start + ((rank > 0) ? 1 : 0);
+	levels[0].rows      = arguments->ranks - ((rank > 0) ? 1 : 0) - ((rank < options->size - 1) ? 1 : 0);
+	levels[0].starts    = allocateMemory((options->size + 1) * sizeof(int));
+	levels[0].stage     = NULL;
+
+	MPI_Allgather(&levels[0].row_start, 1, MPI_INT, levels[0].starts, 1, MPI_INT, options->comm);
+	levels[0].starts[options->size] = arguments->N + 1;
+
+	for (l = 0; l + 1 < MG_MAX_LEVELS && levels[l].N > 2; l++)
+	{
+		fine   = &levels[l];
+		coarse = &levels[l + 1];
+
+		coarse->N        = (fine->N + 1) / 2;
+		coarse->active   = fine->active;
+		coarse->gathered = false;
+		coarse->comm     = fine->comm;
+		coarse->starts   = allocateMemory((fine->active + 1) * sizeof(int));
+		coarse->stage    = NULL;
+
+		fewest = coarse->N + 1;
+
+		for (q = 0; q < fine->active; q++)
+		{
+			mgCoarseRange(fine, q, &first, &last);
+			coarse->starts[q] = first;
+			fewest = (last - first < fewest) ? last - first : fewest;
+		}
+
+		coarse->starts[fine->active] = coarse->N + 1;
+
+		coarsest = (coarse->N <= 2 || l + 2 == MG_MAX_LEVELS);
+
+		if (fine->active > 1 && (fewest < MG_MIN_ROWS || coarsest))
+		{
+			// so wenige Ränge, dass die nächste Stufe wieder ohne Sammeln auskommt
+			active = coarsest ? 1 : (coarse->N + 1) / (4 * MG_MIN_ROWS);
+			active = (active < 1) ? 1 : ((active > fine->active) ? fine->active : active);
+
+			for (q = 0; q < active; q++)
+			{
+				distribute(coarse->N + 1, active, q, &coarse->starts[q], &length);
+			}
+
+			coarse->starts[active] = coarse->N + 1;
+			coarse->active         = active;
+			coarse->gathered       = true;
+
+			if (rank < fine->active)
+			{
+				MPI_Comm_split(fine->comm, (rank < active) ? 0 : MPI_UNDEFINED, rank, &coarse->comm);
+
+				// Platz für die gröberen Zeilen in beiden Richtungen (siehe mgStageRange)
+				mgCoarseRange(fine, rank, &first, &last);
+				coarse->stage = allocateMemory((uint64_t)(last - first + 2) * (coarse->N + 1) * sizeof(double));
+			}
+			else
+			{
+				coarse->comm = MPI_COMM_NULL;
+			}
+		}
+
+		coarse->row_start = (rank < coarse->active) ? coarse->starts[rank] : 0;
+		coarse->rows      = (rank < coarse->active) ? coarse->starts[rank + 1] - coarse->starts[rank] : 0;
+	}
+
+	count = l + 1;
+
+	for (q = 0; q < count; q++)
+	{
+		uint64_t const size = (uint64_t)(levels[q].rows + 2) * (levels[q].N + 1);
+
+		levels[q].v    = NULL;
+		levels[q].f    = NULL;
+		levels[q].r    = NULL;
+		levels[q].work = NULL;
+
+		if (rank >= levels[q].active)
+		{
+			continue;
+		}
+
+		// Ränder und Halos am Rand der Matrix bleiben null
+		levels[q].v = allocateMemory(3 * size * sizeof(double));
+		levels[q].f = levels[q].v + size;
+		levels[q].r = levels[q].v + 2 * size;
+		memset(levels[q].v, 0, 3 * size * sizeof(double));
+
+		// Suchrichtung und A p des CG auf der gröbsten Stufe
+		if (q == count - 1)
+		{
+			levels[q].work = allocateMemory(2 * size * sizeof(double));
+			memset(levels[q].work, 0, 2 * size * sizeof(double));
+		}
+		else if (levels[q].N % 2 != 0)
+		{
+			levels[q].work = allocateMemory(size * sizeof(double));
+			memset(levels[q].work, 0, size * sizeof(double));
+		}
+	}
+
+	return count;
+}
+
+/* ************************************************************************ */
+/* mgFree: frees the levels built by mgInit                                 */
+/* ************************************************************************ */
+static void
+mgFree(struct level* levels, int count)
+{
+	int l;
+
+	for (l = 0; l < count; l++)
+	{
+		if (levels[l].gathered && levels[l].comm != MPI_COMM_NULL)
+		{
+			MPI_Comm_free(&levels[l].comm);
+		}
+
+		free(levels[l].starts);
+		free(levels[l].stage);
+		free(levels[l].v);
+		free(levels[l].work);
+	}
+}
+
+/* ************************************************************************ */
+/* mgExchange: exchanges the halo rows of an array of a level               */
+/* ************************************************************************ */
+static void
+mgExchange(struct level const* level, double* array, int rank)
+{
+	int const width = level->N + 1;
+	int const up    = (rank > 0) ? rank - 1 : MPI_PROC_NULL;
+	int const down  = (rank < level->active - 1) ? rank + 1 : MPI_PROC_NULL;
+
+	double const start = wallTime();
+
+	MPI_Sendrecv(array + width, width, MPI_DOUBLE, up, 0, array + (uint64_t)(level->rows + 1) * width, width, MPI_DOUBLE, down, 0, level->comm, MPI_STATUS_IGNORE);
+	MPI_Sendrecv(array + (uint64_t)level->rows * width, width, MPI_DOUBLE, down, 1, array, width, MPI_DOUBLE, up, 1, level->comm, MPI_STATUS_IGNORE);
+
+	countBytes(up, width);
+	countBytes(down, width);
+	phaseEnd(PHASE_HALO, start);
+}
+
+/* ************************************************************************ */
+/* mgSmooth: red-black Gauß-Seidel sweeps for A v = f                       */
+/*                                                                          */
+/* The colour of a point only depends on its global indices, so the result  */
+/* does not depend on the decomposition.                                    */
+/* ************************************************************************ */
+static void
+mgSmooth(struct level* level, int rank, int sweeps, struct options const* options)
+{
+	int const N = level->N;
+
+	typedef double(*vector)[N + 1];
+
+	vector V = (vector)level->v;
+	vector F = (vector)level->f;
+
+	int sweep, colour, i, j, g;
+
+	for (sweep = 0; sweep < sweeps; sweep++)
+	{
+		for (colour = 0; colour < 2; colour++)
+		{
+			mgExchange(level, level->v, rank);
+
+			#pragma omp parallel for num_threads(options->number) schedule(static) private(j, g)
+			for (i = 1; i <= level->rows; i++)
+			{
+				g = level->row_start + i - 1;
+
+				if (g < 1 || g >= N)
+				{
+					continue;
+				}
+
+				for (j = 1 + (g + 1 + colour) % 2; j < N; j += 2)
+				{
+					V[i][j] = F[i][j] + 0.25 * (V[i - 1][j] + V[i + 1][j] + V[i][j - 1] + V[i][j + 1]);
+				}
+			}
+		}
+	}
+}
+
+/* ************************************************************************ */
+/* mgResidual: r = f - A v on the own rows of a level                       */
+/* returns the maximum norm of the own part of r                            */
+/* ************************************************************************ */
+static double
+mgResidual(struct level* level, int rank, struct options const* options)
+{
+	int const N = level->N;
+
+	typedef double(*vector)[N + 1];
+
+	vector V = (vector)level->v;
+	vector F = (vector)level->f;
+	vector R = (vector)level->r;
+
+	double maxresiduum = 0.0;
+	int    i, j, g;
+
+	mgExchange(level, level->v, rank);
+
+	#pragma omp parallel for num_threads(options->number) schedule(static) private(j, g) reduction(max:maxresiduum)
+	for (i = 1; i <= level->rows; i++)
+	{
+		g = level->row_start + i - 1;
+
+		if (g < 1 || g >= N)
+		{
+			continue;
+		}
+
+		for (j = 1; j < N; j++)
+		{
+			R[i][j]     = F[i][j] - V[i][j] + 0.25 * (V[i - 1][j] + V[i + 1][j] + V[i][j - 1] + V[i][j + 1]);
+			maxresiduum = (fabs(R[i][j]) < maxresiduum) ? maxresiduum : fabs(R[i][j]);
+		}
+	}
+
+	return maxresiduum;
+}
+
+/* ************************************************************************ */
+/* mgRestrict: full weighting of the residual of the finer level into the   */
+/* right-hand side of the coarser one                                       */
+/*                                                                          */
+/* out holds coarse rows from global row out_first on. With the scaling of  */
+/* A (h²/4 times the Laplacian) the coarse right-hand side is (H/h)² times  */
+/* the weighted residual, four for even N.                                  */
+/*                                                                          */
+/* For odd N the coarse points (N + 1) / 2 do not lie on the fine grid: the */
+/* weighted residual is computed on the fine grid into fine->work and then  */
+/* interpolated linearly at the coarse points, between the fine rows and    */
+/* columns 2 I - 1 and 2 I. The exchange of fine->work makes this a         */
+/* collective call on the active ranks of the finer level.                  */
+/* ************************************************************************ */
+static void
+mgRestrict(struct level const* fine, int coarse_N, double* out, int out_first, int rank, struct options const* options)
+{
+	int const N = fine->N;
+
+	typedef double(*vector)[N + 1];
+	typedef double(*coarse_vector)[coarse_N + 1];
+
+	vector        R   = (vector)fine->r;
+	vector        W   = (vector)fine->work;
+	coarse_vector Out = (coarse_vector)out;
+
+	int first, last, I, J, i, j, g;
+
+	mgCoarseRange(fine, rank, &first, &last);
+
+	if (N % 2 != 0)
+	{
+		#pragma omp parallel for num_threads(options->number) schedule(static) private(j, g)
+		for (i = 1; i <= fine->rows; i++)
+		{
+			g = fine->row_start + i - 1;
+
+			if (g < 1 || g >= N)
+			{
+				continue;
+			}
+
+			for (j = 1; j < N; j++)
+			{
+				W[i][j] = (4.0 * R[i][j] + 2.0 * (R[i - 1][j] + R[i + 1][j] + R[i][j - 1] + R[i][j + 1]) + R[i - 1][j - 1] + R[i - 1][j + 1] + R[i + 1][j - 1] + R[i + 1][j + 1]) / 16.0;
+			}
+		}
+
+		mgExchange(fine, fine->work, rank);
+
+		double const scale = ((double)N * N) / ((double)coarse_N * coarse_N);
+
+		#pragma omp parallel for num_threads(options->number) schedule(static) private(J, i, j)
+		for (I = first; I < last; I++)
+		{
+			if (I < 1 || I >= coarse_N)
+			{
+				memset(Out[I - out_first], 0, (coarse_N + 1) * sizeof(double));
+				continue;
+			}
+
+			// grober Punkt I liegt bei der feinen Koordinate I N / coarse_N
+			int64_t const y  = (int64_t)I * N;
+			double const  wy = (double)(y % coarse_N) / coarse_N;
+
+			i = y / coarse_N - fine->row_start + 1;
+
+			for (J = 1; J < coarse_N; J++)
+			{
+				int64_t const x  = (int64_t)J * N;
+				double const  wx = (double)(x % coarse_N) / coarse_N;
+
+				j = x / coarse_N;
+
+				Out[I - out_first][J] = scale * ((1.0 - wy) * ((1.0 - wx) * W[i][j] + wx * W[i][j + 1]) + wy * ((1.0 - wx) * W[i + 1][j] + wx * W[i + 1][j + 1]));
+			}
+		}
+
+		return;
+	}
+
+	#pragma omp parallel for num_threads(options->number) schedule(static) private(J, i, j)
+	for (I = first; I < last; I++)
+	{
+		if (I < 1 || I >= coarse_N)
+		{
+			memset(Out[I - out_first], 0, (coarse_N + 1) * sizeof(double));
+			continue;
+		}
+
+		i = 2 * I - fine->row_start + 1;
+
+		for (J = 1; J < coarse_N; J++)
+		{
+			j = 2 * J;
+
+			Out[I - out_first][J] = (4.0 * R[i][j] + 2.0 * (R[i - 1][j] + R[i + 1][j] + R[i][j - 1] + R[i][j + 1]) + R[i - 1][j - 1] + R[i - 1][j + 1] + R[i + 1][j - 1] + R[i + 1][j + 1]) / 4.0;
+		}
+	}
+}
+
+/* ************************************************************************ */
+/* mgProlong: adds the bilinear interpolation of the coarse correction to   */
+/* the own rows of the finer level                                          */
+/*                                                                          */
+/* in holds coarse rows from global row in_first on. For odd N the fine    */
+/* point i lies at the coarse coordinate i (N + 1) / (2 N), see mgRestrict. */
+/* ************************************************************************ */
+static void
+mgProlong(struct level* fine, double const* in, int in_first, struct options const* options)
+{
+	int const N        = fine->N;
+	int const coarse_N = (N + 1) / 2;
+
+	typedef double(*vector)[N + 1];
+
+	vector V = (vector)fine->v;
+
+	double const(*In)[coarse_N + 1] = (double const(*)[coarse_N + 1])in;
+
+	int i, j, g, I0, I1, J0, J1;
+
+	if (N % 2 != 0)
+	{
+		#pragma omp parallel for num_threads(options->number) schedule(static) private(j, g, I0, J0)
+		for (i = 1; i <= fine->rows; i++)
+		{
+			g = fine->row_start + i - 1;
+
+			if (g < 1 || g >= N)
+			{
+				continue;
+			}
+
+			int64_t const y  = (int64_t)g * coarse_N;
+			double const  wy = (double)(y % N) / N;
+
+			I0 = y / N - in_first;
+
+			for (j = 1; j < N; j++)
+			{
+				int64_t const x  = (int64_t)j * coarse_N;
+				double const  wx = (double)(x % N) / N;
+
+				J0 = x / N;
+
+				V[i][j] += (1.0 - wy) * ((1.0 - wx) * In[I0][J0] + wx * In[I0][J0 + 1]) + wy * ((1.0 - wx) * In[I0 + 1][J0] + wx * In[I0 + 1][J0 + 1]);
+			}
+		}
+
+		return;
+	}
+
+	#pragma omp parallel for num_threads(options->number) schedule(static) private(j, g, I0, I1, J0, J1)
+	for (i = 1; i <= fine->rows; i++)
+	{
+		g = fine->row_start + i - 1;
+
+		if (g < 1 || g >= N)
+		{
+			continue;
+		}
+
+		// gerade Indizes liegen auf dem groben Gitter, ungerade dazwischen
+		I0 = g / 2 - in_first;
+		I1 = (g + 1) / 2 - in_first;
+
+		for (j = 1; j < N; j++)
+		{
+			J0 = j / 2;
+			J1 = (j + 1) / 2;
+
+			V[i][j] += 0.25 * (In[I0][J0] + In[I0][J1] + In[I1][J0] + In[I1][J1]);
+		}
+	}
+}
+
+/* ************************************************************************ */
+/* mgTransfer: moves coarse rows between the stages of the finer level and  */
+/* the ranks of a gathered level with one MPI_Alltoallv                     */
+/*                                                                          */
+/* down: the restricted right-hand side to the owners of the coarse rows,   */
+/* otherwise the coarse correction back (see mgStageRange).                 */
+/* ************************************************************************ */
+static void
+mgTransfer(struct level const* fine, struct level* coarse, int rank, bool down)
+{
+	int const width = coarse->N + 1;
+	int const size  = fine->active;
+
+	int counts[2][size];
+	int displs[2][size];
+
+	int q, first, last, own_first, own_last, stage_first, stage_last, lo, hi;
+
+	// auf der groben Stufe ist dieser Rang eventuell nicht mehr aktiv
+	own_first = (rank < coarse->active) ? coarse->starts[rank] : 0;
+	own_last  = (rank < coarse->active) ? coarse->starts[rank + 1] : 0;
+
+	mgStageRange(fine, rank, down, &stage_first, &stage_last);
+
+	for (q = 0; q < size; q++)
+	{
+		mgStageRange(fine, q, down, &first, &last);
+
+		// [0]: Zeilen aus der eigenen Stufe für Rang q als Besitzer, [1]: eigene grobe Zeilen für die Stufe von Rang q
+		lo = (q < coarse->active) ? ((stage_first > coarse->starts[q]) ? stage_first : coarse->starts[q]) : 0;
+		hi = (q < coarse->active) ? ((stage_last < coarse->starts[q + 1]) ? stage_last : coarse->starts[q + 1]) : 0;
+
+		counts[0][q] = (hi > lo) ? (hi - lo) * width : 0;
+		displs[0][q] = (hi > lo) ? (lo - stage_first) * width : 0;
+
+		lo = (first > own_first) ? first : own_first;
+		hi = (last < own_last) ? last : own_last;
+
+		counts[1][q] = (hi > lo) ? (hi - lo) * width : 0;
+		displs[1][q] = (hi > lo) ? (lo - coarse->row_start + 1) * width : 0;
+	}
+
+	if (down)
+	{
+		MPI_Alltoallv(coarse->stage, counts[0], displs[0], MPI_DOUBLE, coarse->f, counts[1], displs[1], MPI_DOUBLE, fine->comm);
+	}
+	else
+	{
+		MPI_Alltoallv(coarse->v, counts[1], displs[1], MPI_DOUBLE, coarse->stage, counts[0], displs[0], MPI_DOUBLE, fine->comm);
+	}
+}
+
+/* ************************************************************************ */
+/* mgSolveCoarsest: solves A v = f on the coarsest level with CG            */
+/*                                                                          */
+/* The level lives on rank 0 alone, so no communication is needed. CG stops */
+/* after a relative reduction of 1e-6 (enough for the V-cycle) or one step */
+/* per unknown.                                                             */
+/* ************************************************************************ */
+static void
+mgSolveCoarsest(struct level* level)
+{
+	int const      N    = level->N;
+	uint64_t const size = (uint64_t)(level->rows + 2) * (N + 1);
+
+	typedef double(*vector)[N + 1];
+
+	vector V = (vector)level->v;
+	vector F = (vector)level->f;
+	vector R = (vector)level->r;
+	vector P = (vector)level->work;
+	vector Q = (vector)(level->work + size);
+
+	double rr, rr_new, pq, alpha, tolerance;
+	int    i, j, k;
+
+	// lokale Zeile i ist die globale Zeile i - 1, innere Punkte also ab Zeile 2
+	rr = 0.0;
+
+	for (i = 2; i < N + 1; i++)
+	{
+		for (j = 1; j < N; j++)
+		{
+			R[i][j] = F[i][j];
+			P[i][j] = F[i][j];
+			rr += R[i][j] * R[i][j];
+		}
+	}
+
+	tolerance = 1e-12 * rr;
+
+	for (k = 0; k < (N - 1) * (N - 1) && rr > tolerance; k++)
+	{
+		pq = 0.0;
+
+		for (i = 2; i < N + 1; i++)
+		{
+			cgOperatorRow(Q[i], P[i - 1], P[i], P[i + 1], N);
+
+			for (j = 1; j < N; j++)
+			{
+				pq += P[i][j] * Q[i][j];
+			}
+		}
+
+		alpha  = rr / pq;
+		rr_new = 0.0;
+
+		for (i = 2; i < N + 1; i++)
+		{
+			for (j = 1; j < N; j++)
+			{
+				V[i][j] += alpha * P[i][j];
+				R[i][j] -= alpha * Q[i][j];
+				rr_new += R[i][j] * R[i][j];
+			}
+		}
+
+		for (i = 2; i < N + 1; i++)
+		{
+			for (j = 1; j < N; j++)
+			{
+				P[i][j] = R[i][j] + (rr_new / rr) * P[i][j];
+			}
+		}
+
+		rr = rr_new;
+	}
+}
+
+/* ************************************************************************ */
+/* mgCycle: one V-cycle from level l down to the coarsest level             */
+/* only called on the ranks that are active on level l                      */
+/* ************************************************************************ */
+static void
+mgCycle(struct level* levels, int l, int count, int rank, struct options const* options)
+{
+	struct level* fine = &levels[l];
+	struct level* coarse;
+
+	int first, last;
+
+	if (l == count - 1)
+	{
+		mgSolveCoarsest(fine);
+		return;
+	}
+
+	coarse = &levels[l + 1];
+
+	mgSmooth(fine, rank, MG_SMOOTH, options);
+	mgResidual(fine, rank, options);
+	mgExchange(fine, fine->r, rank);
+
+	if (coarse->gathered)
+	{
+		mgStageRange(fine, rank, true, &first, &last);
+		mgRestrict(fine, coarse->N, coarse->stage, first, rank, options);
+		mgTransfer(fine, coarse, rank, true);
+	}
+	else
+	{
+		mgRestrict(fine, coarse->N, coarse->f, coarse->row_start - 1, rank, options);
+	}
+
+	if (rank < coarse->active)
+	{
+		memset(coarse->v, 0, (uint64_t)(coarse->rows + 2) * (coarse->N + 1) * sizeof(double));
+		mgCycle(levels, l + 1, count, rank, options);
+	}
+
+	if (coarse->gathered)
+	{
+		mgTransfer(fine, coarse, rank, false);
+		mgStageRange(fine, rank, false, &first, &last);
+		mgProlong(fine, coarse->stage, first, options);
+	}
+	else
+	{
+		mgExchange(coarse, coarse->v, rank);
+		mgProlong(fine, coarse->v, coarse->row_start - 1, options);
+	}
+
+	mgSmooth(fine, rank, MG_SMOOTH, options);
+}
+
+/* ************************************************************************ */
+/* MPI_multigrid_calculate: solves the equation with multigrid V-cycles     */
+/*                                                                          */
+/* Every cycle counts as one iteration. Afterwards the residual f - A v is  */
+/* computed on the finest level; it is the change of one Jacobi step, so    */
+/* TERM_PREC and the statistics mean the same as for Jacobi.                */
+/* ************************************************************************ */
+static void
+MPI_multigrid_calculate(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
+{
+	struct level levels[MG_MAX_LEVELS];
+
+	struct convergence convergence = { .started = 0 };
+
+	int const    N    = arguments->N;
+	int const    rank = options->rank;
+	double const h    = arguments->h;
+
+	int term_iteration = options->term_iteration;
+
+	typedef double(*vector)[N + 1];
+
+	vector Matrix = (vector)arguments->M;
+	vector V, F;
+
+	double maxresiduum;
+	double pih    = 0.0;
+	double fpisin = 0.0;
+
+	int count, i, j, g;
+
+	if (options->inf_func == FUNC_FPISIN)
+	{
+		pih    = M_PI * h;
+		fpisin = 0.25 * (2 * M_PI * M_PI) * h * h;
+	}
+
+	count = mgInit(levels, arguments, options);
+
+	V = (vector)levels[0].v;
+	F = (vector)levels[0].f;
+
+	// Anfangswerte mit den Randwerten aus der Matrix, rechte Seite aus der Störfunktion
+	for (i = 1; i <= levels[0].rows; i++)
+	{
+		g = levels[0].row_start + i - 1;
+
+		memcpy(V[i], Matrix[g - arguments->row_start], (N + 1) * sizeof(double));
+
+		if (g > 0 && g < N && options->inf_func == FUNC_FPISIN)
+		{
+			for (j = 1; j < N; j++)
+			{
+				F[i][j] = fpisinRow(arguments, options, fpisin, pih, g - arguments->row_start) * sin(pih * (double)j);
+			}
+		}
+	}
+
+	while (term_iteration > 0)
+	{
+		mgCycle(levels, 0, count, rank, options);
+
+		maxresiduum = (options->termination == TERM_PREC || term_iteration == 1) ? mgResidual(&levels[0], rank, options) : 0.0;
+
+		term_iteration = checkTermination(&convergence, maxresiduum, term_iteration, options->comm, results, options);
+	}
+
+	for (i = 1; i <= levels[0].rows; i++)
+	{
+		g = levels[0].row_start + i - 1;
+
+		memcpy(Matrix[g - arguments->row_start], V[i], (N + 1) * sizeof(double));
+	}
+
+	results->levels = count;
+
+	for (i = 0; i < count; i++)
+	{
+		results->level_ranks[i] = levels[i].active;
+	}
+
+	mgFree(levels, count);
+
+	results->m = 0;
+}
+
+/* ************************************************************************ */
+/* calculate: solves the equation with overlapping additive Schwarz         */
+/*                                                                          */
+/* Every rank works on its strip widened by options->overlap ghost rows per */
+/* side (same layout as the deep halos) and bounded by one more halo row.   */
+/* After each exchange it runs options->inner Gauß-Seidel (SOR) sweeps on   */
+/* this subdomain with the halo rows fixed; the ghost rows are replaced by  */
+/* the neighbour's own rows at the next exchange (restricted Schwarz). All  */
+/* ranks sweep at the same time, with one exchange per inner sweeps.        */
+/* The residuum is taken from the own rows in the first inner sweep, when   */
+/* the halos are fresh; it counts as one iteration.                         */
+/* ************************************************************************ */
+static void
+MPI_schwarz_calculate(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
+{
+	MPI_Request requests[4];
+
+	struct convergence convergence = { .started = 0 };
+
+	int    i, s;        /* local variables for loops */
+	double maxresiduum; /* maximum residuum value of a slave in iteration */
+	double start;
+
+	int const    N     = arguments->N;
+	int const    ranks = arguments->ranks;
+	int const    depth = options->overlap + 1;
+	double const h     = arguments->h;
+
+	int const upper = (options->rank > 0) ? options->rank - 1 : MPI_PROC_NULL;
+	int const lower = (options->rank < options->size - 1) ? options->rank + 1 : MPI_PROC_NULL;
+
+	// eigene Zeilen, an den Rändern der Matrix ohne Überlappung
+	int const own_first = (upper != MPI_PROC_NULL) ? depth : 1;
+	int const own_last  = (lower != MPI_PROC_NULL) ? ranks - 1 - depth : ranks - 2;
+
+	double pih    = 0.0;
+	double fpisin = 0.0;
+	double halo_time = 0.0;
+
+	int term_iteration = options->term_iteration;
+
+	typedef double(*matrix)[N + 1];
+
+	matrix Matrix = (matrix)arguments->M;
+
+	if (options->inf_func == FUNC_FPISIN)
+	{
+		pih    = M_PI * h;
+		fpisin = 0.25 * (2 * M_PI * M_PI) * h * h;
+	}
+
+	while (term_iteration > 0)
+	{
+		// Überlappung und Halo-Zeile von den eigenen Zeilen der Nachbarn
+		start = wallTime();
+
+		MPI_Isend(Matrix[own_first], depth * (N + 1), MPI_DOUBLE, upper, 0, options->comm, &requests[0]);
+		MPI_Irecv(Matrix[0], depth * (N + 1), MPI_DOUBLE, upper, 0, options->comm, &requests[1]);
+		MPI_Isend(Matrix[own_last - depth + 1], depth * (N + 1), MPI_DOUBLE, lower, 0, options->comm, &requests[2]);
+		MPI_Irecv(Matrix[ranks - depth], depth * (N + 1), MPI_DOUBLE, lower, 0, options->comm, &requests[3]);
+		MPI_Waitall(4, requests, MPI_STATUSES_IGNORE);
+		countBytes(upper, depth * (N + 1));
+		countBytes(lower, depth * (N + 1));
+
+		halo_time += traceEnd(TRACE_WAIT, start) - start;
+
+		maxresiduum = 0;
+		start       = wallTime();
+
+		for (s = 0; s < options->inner; s++)
+		{
+			/* over all rows of the subdomain, the halo rows stay fixed */
+			for (i = 1; i < ranks - 1; i++)
+			{
+				if (s == 0 && i >= own_first && i <= own_last)
+				{
+					maxresiduum = gaussSeidelRow(Matrix[i], Matrix[i - 1], Matrix[i + 1], 1, N, fpisinRow(arguments, options, fpisin, pih, i), pih, options->sor, maxresiduum);
+				}
+				else
+				{
+					gaussSeidelRow(Matrix[i], Matrix[i - 1], Matrix[i + 1], 1, N, fpisinRow(arguments, options, fpisin, pih, i), pih, options->sor, 0.0);
+				}
+			}
+		}
+
+		traceEnd(TRACE_SWEEP, start);
+
+		term_iteration = checkTermination(&convergence, maxresiduum, term_iteration, options->comm, results, options);
+	}
+
+	// Zeit pro Iteration, gemittelt und als Maximum über die Ränge
+	profile.phase[PHASE_HALO] += halo_time;
+	halo_time /= results->stat_iteration;
+	MPI_Reduce(&halo_time, &results->halo_time[0], 1, MPI_DOUBLE, MPI_SUM, 0, options->comm);
+	MPI_Reduce(&halo_time, &results->halo_time[1], 1, MPI_DOUBLE, MPI_MAX, 0, options->comm);
+	results->halo_time[0] /= options->size;
+
+	results->m = 0;
+}
+
+/* ************************************************************************ */
+/* reduceProfile: collects the phase timers of all ranks on rank 0          */
+/*                                                                          */
+/* Everything of the total time that is neither halo exchange, reduction    */
+/* nor waiting for neighbours on the node is work of the rank. Solvers      */
+/* without their own compute timer count all of it as computation, the      */
+/* others report the rest (setup, pointer swaps) separately. The imbalance  */
+/* is the slowest rank's work over the mean work.                           */
+/* ************************************************************************ */
+static void
+reduceProfile(struct calculation_results* results, struct options const* options)
+{
+	double local[PHASES + 2], minimum[PHASES + 2], sum[PHASES + 2], maximum[PHASES + 2];
+	double work;
+	int    p;
+
+	work = profile.phase[PHASE_TOTAL] - profile.phase[PHASE_HALO] - profile.phase[PHASE_REDUCE] - profile.phase[PHASE_SYNC];
+	work = (work > 0.0) ? work : 0.0;
+
+	if (profile.phase[PHASE_COMPUTE] > 0.0)
+	{
+		profile.phase[PHASE_OTHER] = (work > profile.phase[PHASE_COMPUTE]) ? work - profile.phase[PHASE_COMPUTE] : 0.0;
+	}
+	else
+	{
+		profile.phase[PHASE_COMPUTE] = work;
+	}
+
+	for (p = 0; p < PHASES; p++)
+	{
+		local[p] = profile.phase[p];
+	}
+
+	local[PHASES]     = profile.bytes;
+	local[PHASES + 1] = work;
+
+	MPI_Reduce(local, minimum, PHASES + 2, MPI_DOUBLE, MPI_MIN, 0, options->comm);
+	MPI_Reduce(local, sum, PHASES + 2, MPI_DOUBLE, MPI_SUM, 0, options->comm);
+	MPI_Reduce(local, maximum, PHASES + 2, MPI_DOUBLE, MPI_MAX, 0, options->comm);
+
+	if (options->rank != 0)
+	{
+		return;
+	}
+
+	for (p = 0; p < PHASES + 1; p++)
+	{
+		double* target = (p < PHASES) ? results->phase_time[p] : results->bytes;
+
+		target[0] = minimum[p];
+		target[1] = sum[p] / options->size;
+		target[2] = maximum[p];
+	}
+
+	results->imbalance = (sum[PHASES + 1] > 0.0) ? (maximum[PHASES + 1] * options->size / sum[PHASES + 1] - 1.0) * 100.0 : 0.0;
+}
+
+/* ************************************************************************ */
+/* streamKernel: one timed STREAM kernel on all ranks of a node at once,    */
+/*               returns the bandwidth of the node in GB/s                  */
+/*                                                                          */
+/* 0: copy  c = a          (16 bytes per element)                           */
+/* 1: triad a = b + s * c  (24 bytes per element)                           */
+/* As in STREAM, the read for write allocate is not counted. The threads    */
+/* are pinned like in the solver.                                           */
+/* ************************************************************************ */
+static double
+streamKernel(int kernel, double* a, double* b, double* c, int64_t n, MPI_Comm node, int node_size, struct options const* options, cpu_set_t const* allowed)
+{
+	double const scalar = 3.0;
+	double       time;
+	int64_t      i;
+
+	MPI_Barrier(node);
+	time = wallTime();
+
+	#pragma omp parallel num_threads(options->number)
+	{
+		pinThread(allowed);
+
+		if (kernel == 0)
+		{
+			#pragma omp for schedule(static)
+			for (i = 0; i < n; i++)
+			{
+				c[i] = a[i];
+			}
+		}
+		else
+		{
+			#pragma omp for schedule(static)
+			for (i = 0; i < n; i++)
+			{
+				a[i] = b[i] + scalar * c[i];
+			}
+		}
+	}
+
+	time = wallTime() - time;
+
+	// der Knoten ist erst fertig, wenn sein langsamster Rang fertig ist
+	MPI_Allreduce(MPI_IN_PLACE, &time, 1, MPI_DOUBLE, MPI_MAX, node);
+
+	return ((kernel == 0) ? 16.0 : 24.0) * n * node_size / time * 1e-9;
+}
+
+/* ************************************************************************ */
+/* streamRoofline: bandwidth the ranks of this run can reach together       */
+/*                                                                          */
+/* With --calibrate all ranks of a node run copy and triad at the same time */
+/* on STREAM_ELEMENTS elements per array and node; the best of STREAM_REPS  */
+/* repetitions counts. Rank 0 appends one line per node to                  */
+/* partdiff_stream.dat: host, ranks on the node, threads, copy and triad.   */
+/* Without --calibrate the first rank of every node looks up the last line  */
+/* for its host, ranks and threads. results->stream is the sum of the      */
+/* nodes, or 0 if a node has no measurement.                                */
+/* ************************************************************************ */
+static void
+streamRoofline(struct calculation_results* results, struct options const* options)
+{
+	char const* const name = "partdiff_stream.dat";
+
+	MPI_Comm node;
+	int      node_rank, node_size, found, threads, ranks, r, k;
+	double   own[2] = { 0.0, 0.0 };
+	double   values[2];
+	char     host[64] = { 0 };
+	char     line[256];
+	char     entry[64];
+	FILE*    file;
+
+	MPI_Comm_split_type(options->comm, MPI_COMM_TYPE_SHARED, options->rank, MPI_INFO_NULL, &node);
+	MPI_Comm_rank(node, &node_rank);
+	MPI_Comm_size(node, &node_size);
+
+	gethostname(host, sizeof(host) - 1);
+
+	if (options->calibrate)
+	{
+		int64_t const n = STREAM_ELEMENTS / node_size;
+		int64_t       i;
+		double        expected = 1.0;
+
+		double* a = allocateMemory(n * sizeof(double));
+		double* b = allocateMemory(n * sizeof(double));
+		double* c = allocateMemory(n * sizeof(double));
+
+		cpu_set_t allowed;
+
+		CPU_ZERO(&allowed);
+		sched_getaffinity(0, sizeof(allowed), &allowed);
+
+		// erste Berührung mit derselben Verteilung wie in den Kernen (NUMA)
+		#pragma omp parallel num_threads(options->number)
+		{
+			pinThread(&allowed);
+
+			#pragma omp for schedule(static)
+			for (i = 0; i < n; i++)
+			{
+				a[i] = 1.0;
+				b[i] = 2.0;
+				c[i] = 0.0;
+			}
+		}
+
+		for (r = 0; r < STREAM_REPS; r++)
+		{
+			for (k = 0; k < 2; k++)
+			{
+				double const rate = streamKernel(k, a, b, c, n, node, node_size, options, &allowed);
+
+				own[k] = (rate > own[k]) ? rate : own[k];
+			}
+
+			expected = 2.0 + 3.0 * expected;
+		}
+
+		// das Ergebnis benutzen, damit die Kerne nicht wegoptimiert werden
+		if (a[n / 2] != expected)
+		{
+			printf("STREAM: falsches Ergebnis auf %s\n", host);
+		}
+
+		free(a);
+		free(b);
+		free(c);
+
+		// eine Zeile pro Knoten an Rang 0 schicken, leer bei den übrigen Rängen
+		line[0] = '\0';
+
+		if (node_rank == 0)
+		{
+			snprintf(line, sizeof(line), "%s %d %" PRIu64 " %.3f %.3f\n", host, node_size, options->number, own[0], own[1]);
+		}
+
+		char* lines = (options->rank == 0) ? allocateMemory((size_t)options->size * sizeof(line)) : NULL;
+
+		MPI_Gather(line, sizeof(line), MPI_CHAR, lines, sizeof(line), MPI_CHAR, 0, options->comm);
+
+		if (options->rank == 0)
+		{
+			if ((file = fopen(name, "a")) == NULL)
+			{
+				printf("Kalibrierung %s kann nicht geschrieben werden\n", name);
+			}
+			else
+			{
+				for (r = 0; r < options->size; r++)
+				{
+					fputs(lines + (size_t)r * sizeof(line), file);
+				}
+
+				fclose(file);
+			}
+
+			free(lines);
+		}
+
+		found = 1;
+	}
+	else
+	{
+		found = 1;
+
+		if (node_rank == 0)
+		{
+			found = 0;
+
+			if ((file = fopen(name, "r")) != NULL)
+			{
+				while (fgets(line, sizeof(line), file) != NULL)
+				{
+					if (sscanf(line, "%63s %d %d %lf %lf", entry, &ranks, &threads, &values[0], &values[1]) == 5 && strcmp(entry, host) == 0 && ranks == node_size && threads == (int)options->number)
+					{
+						own[0] = values[0];
+						own[1] = values[1];
+						found  = 1;
+					}
+				}
+
+				fclose(file);
+			}
+		}
+	}
+
+	if (node_rank != 0)
+	{
+		own[0] = 0.0;
+		own[1] = 0.0;
+	}
+
+	MPI_Allreduce(MPI_IN_PLACE, &found, 1, MPI_INT, MPI_MIN, options->comm);
+	MPI_Reduce(own, results->stream, 2, MPI_DOUBLE, MPI_SUM, 0, options->comm);
+
+	if (!found)
+	{
+		results->stream[0] = 0.0;
+		results->stream[1] = 0.0;
+	}
+
+	MPI_Comm_free(&node);
+}
+
+/* ************************************************************************ */
+/* reduceHaloLinks: counts on rank 0 how the ranks reach their neighbours   */
+/*                                                                          */
+/* Neighbours on the same node are read through the shared windows (see     */
+/* allocateSharedMatrices), the others get the halo rows as messages.       */
+/* ************************************************************************ */
+static void
+reduceHaloLinks(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
+{
+	int links[2] = { 0, 0 };
+	int side;
+
+	for (side = 0; side < 2; side++)
+	{
+		if ((side == 0) ? options->rank > 0 : options->rank < options->size - 1)
+		{
+			links[(arguments->shared[side] != NULL) ? 0 : 1]++;
+		}
+	}
+
+	MPI_Reduce(links, results->halo_links, 2, MPI_INT, MPI_SUM, 0, options->comm);
+}
+
+/* ************************************************************************ */
+/* reduceMemory: collects the memory of the ranks on rank 0                 */
+/*                                                                          */
+/* The matrices are counted as allocated on each rank, including the halo   */
+/* rows. The peak resident set (VmHWM) also contains the vectors of CG and  */
+/* multigrid and the buffers of MPI; it is 0 if /proc is not available.     */
+/* ************************************************************************ */
+static void
+reduceMemory(struct calculation_arguments const* arguments, struct calculation_results* results, struct options const* options)
+{
+	double const matrices = (double)arguments->num_matrices * arguments->ranks * arguments->cols * sizeof(double);
+
+	double resident = 0.0;
+	char   line[256];
+	FILE*  file = fopen("/proc/self/status", "r");
+
+	if (file != NULL)
+	{
+		while (fgets(line, sizeof(line), file) != NULL)
+		{
+			if (sscanf(line, "VmHWM: %lf kB", &resident) == 1)
+			{
+				resident *= 1024.0;
+				break;
+			}
+		}
+
+		fclose(file);
+	}
+
+	MPI_Reduce(&matrices, &results->memory[0], 1, MPI_DOUBLE, MPI_MIN, 0, options->comm);
+	MPI_Reduce(&matrices, &results->memory[1], 1, MPI_DOUBLE, MPI_MAX, 0, options->comm);
+	MPI_Reduce(&matrices, &results->memory[2], 1, MPI_DOUBLE, MPI_SUM, 0, options->comm);
+	MPI_Reduce(&resident, &results->resident[0], 1, MPI_DOUBLE, MPI_MAX, 0, options->comm);
+	MPI_Reduce(&resident, &results->resident[1], 1, MPI_DOUBLE, MPI_SUM, 0, options->comm);
+}
+
+/* ************************************************************************ */
+/* bytesPerUpdate: memory traffic of one lattice update in the model used   */
+/*                 for the effective bandwidth, 0 if there is no model      */
+/*                                                                          */
+/* Jacobi reads the old matrix and writes the new one, which is read first  */
+/* because of write allocate (3 x 8 bytes). Gauß-Seidel and the sweeps of   */
+/* Schwarz update in place (2 x 8 bytes). CG and multigrid touch too many   */
+/* vectors and levels for a simple model.                                   */
+/* ************************************************************************ */
+static int
+bytesPerUpdate(struct options const* options)
+{
+	if (JACOBI_SWEEPS(options->method))
+	{
+		return 3 * sizeof(double);
+	}
+	else if (options->method == METH_GAUSS_SEIDEL || options->method == METH_SCHWARZ)
+	{
+		return 2 * sizeof(double);
+	}
+
+	return 0;
+}
+
+/* ************************************************************************ */
+/* sweepsPerIteration: lattice sweeps of one iteration, Schwarz does        */
+/*                     options->inner Gauß-Seidel sweeps per exchange       */
+/* ************************************************************************ */
+static int
+sweepsPerIteration(struct options const* options)
+{
+	return (options->method == METH_SCHWARZ) ? options->inner : 1;
+}
+
+/* ************************************************************************ */
+/*  displayStatistics: displays some statistics about the calculation       */
+/* ************************************************************************ */
+static void
+displayStatistics(struct calculation_arguments const* arguments, struct calculation_results const* results, struct options const* options)
+{
+	int    N    = arguments->N;
+	double time = (comp_time.tv_sec - start_time.tv_sec) + (comp_time.tv_usec - start_time.tv_usec) * 1e-6;
+
+	// jeder Sweep einer Iteration aktualisiert die (N - 1)^2 inneren Punkte
+	double const updates   = (double)results->stat_iteration * sweepsPerIteration(options) * (N - 1) * (N - 1);
+	double const mlups     = updates / time * 1e-6;
+	int const    traffic   = bytesPerUpdate(options);
+	double const bandwidth = updates * traffic / time * 1e-9;
+
+	printf("Berechnungszeit:    %f s\n", time);
+
+	if (options->bench[0] > 0)
+	{
+		printf("Benchmark:          %d Läufe nach %d Aufwärmläufen, Lösungszeit des langsamsten Rangs\n", options->bench[0], options->bench[1]);
+		printf("                    Median %f s, Mittel %f s, Standardabweichung %f s\n", results->bench[0], results->bench[1], results->bench[2]);
+		printf("                    95-%%-Konfidenzintervall des Mittels: %f .. %f s\n", results->bench[3], results->bench[4]);
+	}
+	printf("Initialisierung:    %f s (vor MPI_Init bis zum Start der Berechnung, langsamster Rang)\n", results->setup_time);
+	printf("Zeit pro Iteration: %e s\n", time / results->stat_iteration);
+
+	if (traffic > 0)
+	{
+		printf("Durchsatz:          %.2f MLUP/s, effektiv %.2f GB/s (%d Bytes pro Update)\n", mlups, bandwidth, traffic);
+	}
+	else
+	{
+		printf("Durchsatz:          %.2f MLUP/s\n", mlups);
+	}
+
+	if (traffic > 0 && results->stream[1] > 0.0)
+	{
+		printf("Roofline:           %.2f GB/s STREAM Triad (Copy %.2f GB/s), davon erreicht %.1f %%\n", results->stream[1], results->stream[0], bandwidth / results->stream[1] * 100.0);
+	}
+	else if (traffic > 0)
+	{
+		printf("Roofline:           nicht kalibriert für diese Knoten, Ränge und Threads (--calibrate)\n");
+	}
+
+	if (!results->counted[COUNTER_CYCLES] && !results->counted[COUNTER_INSTRUCTIONS] && !results->counted[COUNTER_LLC_MISSES])
+	{
+		printf("Hardwarezähler:     nicht verfügbar (perf_event_open, siehe /proc/sys/kernel/perf_event_paranoid)\n");
+	}
+	else
+	{
+		double const flops = results->counters[COUNTER_FP] + 2 * results->counters[COUNTER_FP + 1] + 4 * results->counters[COUNTER_FP + 2] + 8 * results->counters[COUNTER_FP + 3];
+
+		printf("Hardwarezähler:     nur die Berechnung, Summe über alle Threads und Ränge\n");
+		printf(results->counted[COUNTER_CYCLES] ? "  Takte:            %e\n" : "  Takte:            nicht verfügbar\n", results->counters[COUNTER_CYCLES]);
+
+		if (results->counted[COUNTER_INSTRUCTIONS] && results->counted[COUNTER_CYCLES])
+		{
+			printf("  Instruktionen:    %e (IPC %.2f)\n", results->counters[COUNTER_INSTRUCTIONS], results->counters[COUNTER_INSTRUCTIONS] / results->counters[COUNTER_CYCLES]);
+		}
+		else
+		{
+			printf(results->counted[COUNTER_INSTRUCTIONS] ? "  Instruktionen:    %e\n" : "  Instruktionen:    nicht verfügbar\n", results->counters[COUNTER_INSTRUCTIONS]);
+		}
+
+		if (results->counted[COUNTER_LLC_MISSES])
+		{
+			printf("  LLC-Misses:       %e (%.2f Bytes pro Gitterpunkt-Update)\n", results->counters[COUNTER_LLC_MISSES], results->counters[COUNTER_LLC_MISSES] * CACHE_LINE / updates);
+		}
+		else
+		{
+			printf("  LLC-Misses:       nicht verfügbar\n");
+		}
+
+		if (results->counted[COUNTER_FP] && results->counted[COUNTER_FP + 1] && results->counted[COUNTER_FP + 2] && results->counted[COUNTER_FP + 3])
+		{
+			printf("  FP-Operationen:   %e (%.2f pro Gitterpunkt-Update)\n", flops, flops / updates);
+		}
+		else
+		{
+			printf("  FP-Operationen:   nicht verfügbar (nur Intel ab Broadwell)\n");
+		}
+	}
+
+	printf("Speicherbedarf:     %f MiB Matrizen, %f .. %f MiB pro Rang\n", results->memory[2] / 1024.0 / 1024.0, results->memory[0] / 1024.0 / 1024.0, results->memory[1] / 1024.0 / 1024.0);
+	printf("  resident (Spitze): %f MiB, höchstens %f MiB pro Rang\n", results->resident[1] / 1024.0 / 1024.0, results->resident[0] / 1024.0 / 1024.0);
+	printf("Berechnungsmethode: ");
+
+	if (options->method == METH_GAUSS_SEIDEL)
+	{
+		printf("Gauß-Seidel");
+	}
+	else if (options->method == METH_JACOBI)
+	{
+		printf("Jacobi");
+	}
+	else if (options->method == METH_CHEBYSHEV)
+	{
+		printf("Jacobi (Tschebyscheff)");
+	}
+	else if (options->method == METH_CG && options->precond == PRECOND_SSOR)
+	{
+		printf("CG (pipelined), SSOR mit omega = %g", options->ssor_omega);
+	}
+	else if (options->method == METH_CG)
+	{
+		printf("CG (pipelined), Jacobi");
+	}
+	else if (options->method == METH_MULTIGRID)
+	{
+		printf("Mehrgitter (V-Zyklen)");
+	}
+	else if (options->method == METH_SCHWARZ)
+	{
+		printf("additives Schwarz, Überlappung %d, %d Sweeps mit omega = %g", options->overlap, options->inner, options->sor);
+	}
+
+	printf("\n");
+	printf("Interlines:         %" PRIu64 "\n", options->interlines);
+	printf("Stoerfunktion:      ");
+
+	if (options->inf_func == FUNC_F0)
+	{
+		printf("f(x,y) = 0");
+	}
+	else if (options->inf_func == FUNC_FPISIN)
+	{
+		printf("f(x,y) = 2 * pi^2 * sin(pi * x) * sin(pi * y)");
+	}
+
+	printf("\n");
+	printf("Terminierung:       ");
+
+	if (options->termination == TERM_PREC)
+	{
+		printf("Hinreichende Genaugkeit");
+	}
+	else if (options->termination == TERM_ITER)
+	{
+		printf("Anzahl der Iterationen");
+	}
+
+	printf("\n");
+	printf("Anzahl Iterationen: %" PRIu64 "\n", results->stat_iteration);
+
+	if (options->termination == TERM_PREC && options->method != METH_CG && !options->async)
+	{
+		printf("  davon nachgelaufen: %" PRIu64 " (Abbruch wird %d Iteration(en) später erkannt)\n", results->stat_lagged, options->lag);
+	}
+
+	printf("Norm des Fehlers:   %e\n", results->stat_precision);
+
+	if ((JACOBI_SWEEPS(options->method) || options->method == METH_CG || options->method == METH_SCHWARZ) && options->grid[0] == 0)
+	{
+		static char const* const halo_names[] = { "isend", "persistent", "neighbor", "put" };
+
+		int const depth = (options->method == METH_SCHWARZ) ? options->overlap + 1 : options->depth;
+
+		// Nachbarn auf demselben Knoten werden über die Fenster gelesen, nicht verschickt
+		char const* const shm = (results->halo_links[0] == 0) ? "" : ((results->halo_links[1] == 0) ? "shm" : "shm+");
+		char const* const sent = (results->halo_links[0] > 0 && results->halo_links[1] == 0) ? "" : (options->async ? "async" : halo_names[options->halo]);
+
+		printf("Halo-Austausch:     %s%s, Tiefe %d, %e s pro Iteration (Mittel), %e s (Maximum)\n", shm, sent, depth, results->halo_time[0], results->halo_time[1]);
+	}
+
+	if (options->size > 1)
+	{
+		printf("Nachbarpaare:       %d über Knoten, %d über Sockel (vorher %d, %d)\n", options->crossings[1][0], options->crossings[1][1], options->crossings[0][0], options->crossings[0][1]);
+	}
+
+	if (options->tiles > 0)
+	{
+		printf("Überzerlegung:      %d Kacheln pro Rang\n", options->tiles);
+	}
+
+	if (options->async)
+	{
+		printf("Asynchron:          %" PRIu64 " .. %" PRIu64 " Sweeps pro Rang\n", results->async_sweeps[0], results->async_sweeps[1]);
+	}
+
+	if (results->levels > 0)
+	{
+		uint64_t coarsest = arguments->N;
+
+		for (int l = 1; l < results->levels; l++)
+		{
+			coarsest = (coarsest + 1) / 2;
+		}
+
+		printf("Mehrgitter:         %d Stufen bis N = %" PRIu64 ", Ränge pro Stufe:", results->levels, coarsest);
+
+		for (int l = 0; l < results->levels; l++)
+		{
+			printf(" %d", results->level_ranks[l]);
+		}
+
+		printf("\n");
+	}
+
+	if (results->rebalances > 0)
+	{
+		printf("Lastverteilung:     %d Umverteilung(en), %d .. %d Zeilen pro Rang\n", results->rebalances, results->rows[0], results->rows[1]);
+	}
+
+	printf("Laufzeit pro Rang:        Minimum       Mittel      Maximum\n");
+
+	for (int p = 0; p < PHASES; p++)
+	{
+		static char const* const phase_names[] = { "Rechnen", "Halo-Austausch", "Reduktion", "Synchronisation", "Sonstiges", "Gesamt" };
+
+		printf("  %-18s %10.6f s %10.6f s %10.6f s\n", phase_names[p], results->phase_time[p][0], results->phase_time[p][1], results->phase_time[p][2]);
+	}
+
+	printf("  %-18s %8.3f MiB %8.3f MiB %8.3f MiB\n", "gesendet", results->bytes[0] / 1024.0 / 1024.0, results->bytes[1] / 1024.0 / 1024.0, results->bytes[2] / 1024.0 / 1024.0);
+	printf("Lastungleichgewicht: %.1f %% (langsamster Rang gegenüber dem Mittel, ohne Kommunikation)\n", results->imbalance);
+
+	// eine Zeile für Skripte, z.B. grep '^{"partdiff"'
+	printf("{\"partdiff\": 1, \"method\": %" PRIu64 ", \"interlines\": %" PRIu64 ", \"ranks\": %d, \"threads\": %" PRIu64 ", \"iterations\": %" PRIu64 ", ", options->method, options->interlines, options->size, options->number, results->stat_iteration);
+	printf("\"setup_s\": %.6f, \"solve_s\": %.6f, \"iteration_s\": %.6e, \"mlups\": %.3f, ", results->setup_time, time, time / results->stat_iteration, mlups);
+
+	if (traffic > 0)
+	{
+		printf("\"bandwidth_gbs\": %.3f, ", bandwidth);
+	}
+	else
+	{
+		printf("\"bandwidth_gbs\": null, ");
+	}
+
+	if (results->stream[1] > 0.0)
+	{
+		printf("\"stream_triad_gbs\": %.3f, ", results->stream[1]);
+	}
+	else
+	{
+		printf("\"stream_triad_gbs\": null, ");
+	}
+
+	printf("\"memory_mib\": %.3f, \"memory_rank_max_mib\": %.3f, \"resident_mib\": %.3f, \"resident_rank_max_mib\": %.3f}\n", results->memory[2] / 1024.0 / 1024.0, results->memory[1] / 1024.0 / 1024.0, results->resident[1] / 1024.0 / 1024.0, results->resident[0] / 1024.0 / 1024.0);
+
+	// eine CSV-Zeile pro Konfiguration, z.B. grep '^bench,' über alle Läufe eines Jobskripts
+	if (options->bench[0] > 0)
+	{
+		printf("# bench,method,interlines,ranks,threads,iterations,reps,warmup,median_s,mean_s,stddev_s,ci95_low_s,ci95_high_s\n");
+		printf("bench,%" PRIu64 ",%" PRIu64 ",%d,%" PRIu64 ",%" PRIu64 ",%d,%d,%.6f,%.6f,%.6f,%.6f,%.6f\n", options->method, options->interlines, options->size, options->number, results->stat_iteration, options->bench[0], options->bench[1], results->bench[0], results->bench[1], results->bench[2], results->bench[3], results->bench[4]);
+	}
+
+	printf("\n");
+}
+
+/****************************************************************************/
+/** Beschreibung der Funktion displayMatrix:                               **/
+/**                                                                        **/
+/** Die Funktion displayMatrix gibt eine Matrix                            **/
+/** in einer "ubersichtlichen Art und Weise auf die Standardausgabe aus.   **/
+/**                                                                        **/
+/** Die "Ubersichtlichkeit wird erreicht, indem nur ein Teil der Matrix    **/
+/** ausgegeben wird. Aus der Matrix werden die Randzeilen/-spalten sowie   **/
+/** sieben Zwischenzeilen ausgegeben.                                      **/
+/****************************************************************************/
+static void
+displayMatrix(struct calculation_arguments* arguments, struct calculation_results* results, struct options* options)
+{
+	int x, y;
+
+	int const interlines = options->interlines;
+	int const N          = arguments->N;
+
+	typedef double(*matrix)[N + 1][N + 1];
+
+	matrix Matrix = (matrix)arguments->M;
+
+	printf("Matrix:\n");
+
+	for (y = 0; y < 9; y++)
+	{
+		for (x = 0; x < 9; x++)
+		{
+			printf("%7.4f", Matrix[results->m][y * (interlines + 1)][x * (interlines + 1)]);
+		}
+
+		printf("\n");
+	}
+
+	fflush(stdout);
+}
+
+/* ************************************************************************ */
+/* gatherSamples: collects samples x samples points of the matrix on rank 0 */
+/*                                                                          */
+/* The points lie at the global rows/columns k * N / (samples - 1), with    */
+/* samples = 9 exactly the rows and columns of displayMatrixMpi. Every rank */
+/* packs the points of its own block contiguously and rank 0 fetches them   */
+/* with a single MPI_Gatherv. Works for strips (also with deep halos) and   */
+/* for the 2D decomposition. values is only valid on rank 0.                */
+/* ************************************************************************ */
+static void
+gatherSamples(struct calculation_arguments const* arguments, struct calculation_results const* results, struct options const* options, int samples, double* values)
+{
+	int const N    = arguments->N;
+	int const rows = arguments->ranks;
+	int const cols = arguments->cols;
+	int const m    = results->m;
+
+	typedef double(*matrix)[rows][cols];
+
+	matrix Matrix = (matrix)arguments->M;
+
+	// eigener Block in globalen Indizes, die Ränder gehören den Rängen am Rand
+	int const row_first = (arguments->row_start == 0) ? 0 : arguments->row_start + arguments->ghost[0] + 1;
+	int const row_last  = (arguments->row_start + rows - 1 == N) ? N : arguments->row_start + rows - 2 - arguments->ghost[1];
+	int const col_first = (arguments->col_start == 0) ? 0 : arguments->col_start + 1;
+	int const col_last  = (arguments->col_start + cols - 1 == N) ? N : arguments->col_start + cols - 2;
+
+	// Rechteck der Stichproben dieses Rangs: erste Zeile, Anzahl Zeilen, erste Spalte, Anzahl Spalten
+	int block[4] = { 0, 0, 0, 0 };
+	int k, x, y, r;
+
+	for (k = 0; k < samples; k++)
+	{
+		int const index = (int64_t)k * N / (samples - 1);
+
+		if (index >= row_first && index <= row_last)
+		{
+			block[0] = (block[1] == 0) ? k : block[0];
+			block[1]++;
+		}
+
+		if (index >= col_first && index <= col_last)
+		{
+			block[2] = (block[3] == 0) ? k : block[2];
+			block[3]++;
+		}
+	}
+
+	double* local = allocateMemory((block[1] * block[3] + 1) * sizeof(double));
+
+	for (y = 0; y < block[1]; y++)
+	{
+		int const line = (int64_t)(block[0] + y) * N / (samples - 1);
+
+		for (x = 0; x < block[3]; x++)
+		{
+			int const col = (int64_t)(block[2] + x) * N / (samples - 1);
+
+			local[y * block[3] + x] = Matrix[m][line - arguments->row_start][col - arguments->col_start];
+		}
+	}
+
+	int*    blocks = NULL;
+	int*    counts = NULL;
+	int*    displs = NULL;
+	double* packed = NULL;
+
+	if (options->rank == 0)
+	{
+		blocks = allocateMemory(4 * options->size * sizeof(int));
+		counts = allocateMemory(options->size * sizeof(int));
+		displs = allocateMemory(options->size * sizeof(int));
+		packed = allocateMemory(samples * samples * sizeof(double));
+	}
+
+	MPI_Gather(block, 4, MPI_INT, blocks, 4, MPI_INT, 0, options->comm);
+
+	if (options->rank == 0)
+	{
+		for (r = 0; r < options->size; r++)
+		{
+			counts[r] = blocks[4 * r + 1] * blocks[4 * r + 3];
+			displs[r] = (r == 0) ? 0 : displs[r - 1] + counts[r - 1];
+		}
+	}
+
+	MPI_Gatherv(local, block[1] * block[3], MPI_DOUBLE, packed, counts, displs, MPI_DOUBLE, 0, options->comm);
+
+	if (options->rank == 0)
+	{
+		// Rechtecke der Ränge in das Raster einsortieren
+		for (r = 0; r < options->size; r++)
+		{
+			int const* b = &blocks[4 * r];
+
+			for (y = 0; y < b[1]; y++)
+			{
+				for (x = 0; x < b[3]; x++)
+				{
+					values[(b[0] + y) * samples + b[2] + x] = packed[displs[r] + y * b[3] + x];
+				}
 			}
+		}
 
-			/* over all columns */
-			for (j = 1; j < N; j++)
+		free(blocks);
+		free(counts);
+		free(displs);
+		free(packed);
+	}
+
+	free(local);
+}
+
+/* ************************************************************************ */
+/* displayMatrixMpi: prints 9 x 9 samples of the matrix on rank 0           */
+/* ************************************************************************ */
+static void
+displayMatrixMpi(struct calculation_arguments* arguments, struct calculation_results* results, struct options* options)
+{
+	double values[9][9];
+
+	int x, y;
+
+	gatherSamples(arguments, results, options, 9, &values[0][0]);
+
+	if (options->rank == 0)
+	{
+		printf("Matrix:\n");
+
+		for (y = 0; y < 9; y++)
+		{
+			for (x = 0; x < 9; x++)
+			{
+				printf("%7.4f", values[y][x]);
+			}
+
+			printf("\n");
+		}
+	}
+
+	fflush(stdout);
+}
+
+/* ************************************************************************ */
+/* writePreview: writes samples x samples points of the matrix as text to   */
+/* name, one matrix row per line (e.g. for gnuplot "matrix")                */
+/* ************************************************************************ */
+static void
+writePreview(struct calculation_arguments* arguments, struct calculation_results* results, struct options* options, int samples, char const* name)
+{
+	double* values = NULL;
+
+	int x, y;
+
+	if (options->rank == 0)
+	{
+		values = allocateMemory(samples * samples * sizeof(double));
+	}
+
+	gatherSamples(arguments, results, options, samples, values);
+
+	if (options->rank == 0)
+	{
+		FILE* file = fopen(name, "w");
+
+		if (file == NULL)
+		{
+			printf("Vorschau %s kann nicht geschrieben werden\n", name);
+		}
+		else
+		{
+			for (y = 0; y < samples; y++)
+			{
+				for (x = 0; x < samples; x++)
+				{
+					fprintf(file, (x == 0) ? "%.6e" : " %.6e", values[y * samples + x]);
+				}
+
+				fprintf(file, "\n");
+			}
+
+			fclose(file);
+		}
+
+		free(values);
+	}
+}
+
+/* ************************************************************************ */
+/* traceClock: offset of the clock of rank 0 against the own clock          */
+/*                                                                          */
+/* Every rank asks rank 0 for its time TRACE_ROUNDS times and keeps the     */
+/* answer with the shortest round trip, assumed to be taken in its middle.  */
+/* local is set to the own time of that measurement.                        */
+/* ************************************************************************ */
+static double
+traceClock(struct options const* options, double* local)
+{
+	double offset = 0.0;
+	double best   = -1.0;
+	double sent, received, now;
+	int    r, k;
+
+	*local = wallTime();
+
+	for (r = 1; r < options->size; r++)
+	{
+		for (k = 0; k < TRACE_ROUNDS; k++)
+		{
+			if (options->rank == 0)
 			{
-				star = Matrix[m2][i][j] - (0.25 * (Matrix[m2][i - 1][j] + Matrix[m2][i][j - 1] + Matrix[m2][i][j + 1] + Matrix[m2][i + 1][j]));
-				residuum = -star;
-				if (options->inf_func == FUNC_FPISIN)
+				MPI_Recv(&sent, 1, MPI_DOUBLE, r, 77, options->comm, MPI_STATUS_IGNORE);
+				now = wallTime();
+				MPI_Send(&now, 1, MPI_DOUBLE, r, 77, options->comm);
+			}
+			else if (options->rank == r)
+			{
+				sent = wallTime();
+				MPI_Send(&sent, 1, MPI_DOUBLE, 0, 77, options->comm);
+				MPI_Recv(&received, 1, MPI_DOUBLE, 0, 77, options->comm, MPI_STATUS_IGNORE);
+				now = wallTime();
+
+				if (best < 0.0 || now - sent < best)
 				{
-					// star = fpisin_i * sin(pih * (double)j);
-					residuum = (fpisin_i * sin(pih * (double)j)) - star;
+					best   = now - sent;
+					*local = 0.5 * (sent + now);
+					offset = received - *local;
 				}
+			}
+		}
+	}
+
+	return offset;
+}
+
+/* ************************************************************************ */
+/* traceInit: allocates the ring buffers of the threads and measures the    */
+/*            clock offset to rank 0 before the calculation                 */
+/* ************************************************************************ */
+static void
+traceInit(struct options const* options)
+{
+	int t;
+
+	trace.capacity = options->trace;
+	trace.threads  = options->number;
+
+	if (trace.capacity == 0)
+	{
+		return;
+	}
+
+	trace.buffers = allocateMemory(trace.threads * sizeof(struct trace_buffer*));
+
+	// vorab anfassen, damit während der Rechnung keine Seitenfehler anfallen
+	for (t = 0; t < trace.threads; t++)
+	{
+		size_t const size = sizeof(struct trace_buffer) + (size_t)trace.capacity * sizeof(struct trace_event);
+
+		trace.buffers[t] = allocateMemory(size);
+		memset(trace.buffers[t], 0, size);
+	}
+
+	trace.sync[0][1] = traceClock(options, &trace.sync[0][0]);
+	trace.origin     = trace.sync[0][0] + trace.sync[0][1];
+
+	MPI_Bcast(&trace.origin, 1, MPI_DOUBLE, 0, options->comm);
+}
+
+/* ************************************************************************ */
+/* traceWrite: writes the events of all ranks as Chrome trace JSON          */
+/*                                                                          */
+/* The clock offset to rank 0 is measured again after the calculation and  */
+/* interpolated linearly in between, so drift between the nodes is         */
+/* corrected as well. Rank 0 receives the events rank by rank and writes    */
+/* them as complete events ("ph": "X") in microseconds, pid is the rank     */
+/* and tid the thread. The file opens in chrome://tracing or Perfetto.      */
+/* ************************************************************************ */
+static void
+traceWrite(struct options const* options, char const* name)
+{
+	static char const* const kind_names[TRACE_KINDS] = { "Sweep", "Halo senden", "Halo warten", "Reduktion", "Synchronisation" };
+
+	double*  values;
+	uint64_t count = 0, dropped = 0, total = 0, e, n;
+	double   drift = 0.0;
+	int      t, r;
+	FILE*    file = NULL;
+
+	if (trace.capacity == 0)
+	{
+		return;
+	}
+
+	trace.sync[1][1] = traceClock(options, &trace.sync[1][0]);
+
+	if (trace.sync[1][0] > trace.sync[0][0])
+	{
+		drift = (trace.sync[1][1] - trace.sync[0][1]) / (trace.sync[1][0] - trace.sync[0][0]);
+	}
+
+	for (t = 0; t < trace.threads; t++)
+	{
+		n        = trace.buffers[t]->count;
+		count   += (n < (uint64_t)trace.capacity) ? n : (uint64_t)trace.capacity;
+		dropped += (n < (uint64_t)trace.capacity) ? 0 : n - trace.capacity;
+	}
+
+	// je Ereignis Thread, Art, Beginn und Dauer in Mikrosekunden auf der Uhr von Rang 0
+	values = allocateMemory((count > 0 ? count : 1) * 4 * sizeof(double));
+	count  = 0;
+
+	for (t = 0; t < trace.threads; t++)
+	{
+		struct trace_buffer const* buffer = trace.buffers[t];
+
+		e = (buffer->count > (uint64_t)trace.capacity) ? buffer->count - trace.capacity : 0;
+
+		for (; e < buffer->count; e++)
+		{
+			struct trace_event const* event = &buffer->events[e % trace.capacity];
+
+			double const offset = trace.sync[0][1] + drift * (event->begin - trace.sync[0][0]);
 
-				//if (options->term_iteration == TERM_PREC || term_iteration == 1) {
-				//	residuum    = Matrix[m2][i][j] - star;
-				//	residuum    = fabs(residuum);
-				//	maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
-				//}
-				//Matrix[m1][i][j] = star;
-				Matrix[m1][i][j] = Matrix[m2][i][j] + residuum;
-				residuum = fabs(residuum);
-				maxresiduum = (residuum < maxresiduum) ? maxresiduum : residuum;
+			values[4 * count + 0] = t;
+			values[4 * count + 1] = event->kind;
+			values[4 * count + 2] = (event->begin + offset - trace.origin) * 1e6;
+			values[4 * count + 3] = (event->end - event->begin) * 1e6;
+			count++;
+		}
+
+		free(trace.buffers[t]);
+	}
+
+	free(trace.buffers);
+	trace.capacity = 0;
+
+	MPI_Reduce(&dropped, &total, 1, MPI_UINT64_T, MPI_SUM, 0, options->comm);
+
+	if (options->rank != 0)
+	{
+		MPI_Send(&count, 1, MPI_UINT64_T, 0, 78, options->comm);
+		MPI_Send(values, count * 4, MPI_DOUBLE, 0, 78, options->comm);
+		free(values);
+		return;
+	}
 
-				if (options->rank > 0) {
-					// printf("Helllooo %d\n", options->rank);
-				}	
+	file = fopen(name, "w");
+
+	if (file == NULL)
+	{
+		printf("Zeitleiste %s kann nicht geschrieben werden\n", name);
+	}
+	else
+	{
+		fprintf(file, "{\"displayTimeUnit\": \"ms\", \"otherData\": {\"overwritten\": %" PRIu64 "}, \"traceEvents\": [\n", total);
+	}
+
+	for (r = 0; r < options->size; r++)
+	{
+		// Ereignisse der anderen Ränge nacheinander abholen, der Puffer wächst bei Bedarf
+		if (r > 0)
+		{
+			MPI_Recv(&n, 1, MPI_UINT64_T, r, 78, options->comm, MPI_STATUS_IGNORE);
 
+			if (n > count)
+			{
+				free(values);
+				values = allocateMemory(n * 4 * sizeof(double));
 			}
-			
-			/* in der ersten Iteration senden alle Raenge bis		*/ 
- 			/* auf den ersten ihren oberste Zeile an den vorherigen Rang    */
-			if(i == 1){
-				if (options->rank > 0) {
-					MPI_Send(Matrix[m1][1], N + 1, MPI_DOUBLE, options->rank - 1, 421, MPI_COMM_WORLD);
-				}
-			} else if (i == (int)arguments->ranks - 2) {
-				// MPI_Wait(&upper[1], &status);
-				if (options->rank > 0) {
-					// printf("hello %d\n",options->rank);
-				}
-			}
+
+			count = n;
+			MPI_Recv(values, count * 4, MPI_DOUBLE, r, 78, options->comm, MPI_STATUS_IGNORE);
 		}
 
-		
-		// printf("Step 3 %d\n", options->rank);	
-		/* Sende vorletzte Zeile and nächten Rang */
-		if(options->rank < options->size - 1){
-			if (!first_iteration) {
-				// MPI_Wait(&lower[0], &status);
-			}
-			MPI_Send(Matrix[m1][arguments->ranks - 2], N + 1, MPI_DOUBLE, options->rank + 1, 422, MPI_COMM_WORLD);
+		if (file == NULL)
+		{
+			continue;
 		}
-		
-		if(options->rank > 0) {
-			// MPI_Wait(&upper[0],&status);
+
+		fprintf(file, "%s{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %d, \"args\": {\"name\": \"Rang %d\"}}", (r == 0) ? "" : ",\n", r, r);
+
+		for (e = 0; e < count; e++)
+		{
+			fprintf(file, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": %d, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}", kind_names[(int)values[4 * e + 1]], r, (int)values[4 * e], values[4 * e + 2], values[4 * e + 3]);
 		}
+	}
 
-		results->stat_iteration++;
-		/* exchange m1 and m2 */
-		i  = m1;
-		m1 = m2;
-		m2 = i;
+	if (file != NULL)
+	{
+		fprintf(file, "\n]}\n");
+		fclose(file);
 
-		/* check for stopping calculation depending on termination method */
-		if (options->termination == TERM_PREC)
+		if (total > 0)
 		{
-			if (options->rank == options->size-1) {
-			/* letzter Rang uberprüft Abbruchkriterum und sendet term_iteration an ersten Rang */
-				if (maxresiduum < options->term_precision) {
-					term_iteration = 0;
-					MPI_Send(&term_iteration, 1, MPI_INT, 0 , 420, MPI_COMM_WORLD);
-				} else{
-					MPI_Send(&term_iteration, 1, MPI_INT, 0 , 420, MPI_COMM_WORLD);
-				}
-			}
-			if (options->rank < options->size-1) {
-			/* Sende aktuellen maximalen Fehler and nächsten Rang */
-				MPI_Send(&maxresiduum, 1, MPI_INT, options->rank + 1, 423, MPI_COMM_WORLD);
-			}
+			printf("Zeitleiste: %" PRIu64 " ältere Ereignisse überschrieben, --trace=E vergrößert die Puffer\n", total);
 		}
-		else if (options->termination == TERM_ITER)
+	}
+
+	free(values);
+}
+
+/* ************************************************************************ */
+/* counterOpen: opens a counter of the calling thread in user space,        */
+/*              disabled until countersStart enables it                     */
+/* ************************************************************************ */
+static int
+counterOpen(uint32_t type, uint64_t config)
+{
+	struct perf_event_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.size           = sizeof(attr);
+	attr.type           = type;
+	attr.config         = config;
+	attr.disabled       = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv     = 1;
+	attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+	return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+/* ************************************************************************ */
+/* fpCounters: whether the CPU has the FP_ARITH_INST_RETIRED events         */
+/*                                                                          */
+/* There is no generic perf event for floating point operations. Intel has  */
+/* FP_ARITH_INST_RETIRED (event 0xc7) since Broadwell, older Intel and      */
+/* other vendors use the event number for something else.                   */
+/* ************************************************************************ */
+static bool
+fpCounters(void)
+{
+#if defined(__x86_64__)
+	static char const* const older[] = { "nehalem", "westmere", "sandybridge", "ivybridge", "haswell" };
+
+	char  name[32];
+	FILE* file;
+	int   ret, i;
+
+	if (!__builtin_cpu_is("intel") || (file = fopen("/sys/bus/event_source/devices/cpu/caps/pmu_name", "r")) == NULL)
+	{
+		return false;
+	}
+
+	ret = fscanf(file, "%31s", name);
+	fclose(file);
+
+	for (i = 0; i < (int)(sizeof(older) / sizeof(older[0])); i++)
+	{
+		if (ret == 1 && strcmp(name, older[i]) == 0)
 		{
-			term_iteration--;
+			return false;
 		}
-		first_iteration = false;
 	}
-	// printf("Step 2 %d\n", options->rank);
-	/* Fehler zusammen rechnen */
-	MPI_Allreduce(&maxresiduum, &(results->stat_precision), 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
 
-	results->m = m2;
+	return ret == 1;
+#else
+	return false;
+#endif
 }
 
 /* ************************************************************************ */
-/*  displayStatistics: displays some statistics about the calculation       */
+/* countersStart: opens and enables the hardware counters of every thread   */
+/*                                                                          */
+/* perf_event_open counts the thread that opened the counter, so every      */
+/* OpenMP thread opens its own. The solvers use the same number of threads, */
+/* so the runtime hands their work to exactly these threads. Counters that  */
+/* cannot be opened (no PMU, perf_event_paranoid) stay at -1.               */
 /* ************************************************************************ */
 static void
-displayStatistics(struct calculation_arguments const* arguments, struct calculation_results const* results, struct options const* options)
+countersStart(struct options const* options)
 {
-	int    N    = arguments->N;
-	double time = (comp_time.tv_sec - start_time.tv_sec) + (comp_time.tv_usec - start_time.tv_usec) * 1e-6;
+	bool const fp = fpCounters();
+	int        t, c;
 
-	printf("Berechnungszeit:    %f s\n", time);
-	printf("Speicherbedarf:     %f MiB\n", (N + 1) * (N + 1) * sizeof(double) * arguments->num_matrices / 1024.0 / 1024.0);
-	printf("Berechnungsmethode: ");
+	counter_fds = allocateMemory(options->number * sizeof(*counter_fds));
 
-	if (options->method == METH_GAUSS_SEIDEL)
+	for (t = 0; t < (int)options->number; t++)
 	{
-		printf("Gauß-Seidel");
+		for (c = 0; c < COUNTERS; c++)
+		{
+			counter_fds[t][c] = -1;
+		}
 	}
-	else if (options->method == METH_JACOBI)
+
+	#pragma omp parallel num_threads(options->number) private(c)
 	{
-		printf("Jacobi");
+		// FP_ARITH_INST_RETIRED: umask 0x01 skalar, 0x04 128 Bit, 0x10 256 Bit, 0x40 512 Bit
+		static uint64_t const configs[COUNTERS] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, 0x01c7, 0x04c7, 0x10c7, 0x40c7 };
+
+		int* fds = counter_fds[omp_get_thread_num()];
+
+		for (c = 0; c < COUNTERS; c++)
+		{
+			if (c < COUNTER_FP || fp)
+			{
+				fds[c] = counterOpen((c < COUNTER_FP) ? PERF_TYPE_HARDWARE : PERF_TYPE_RAW, configs[c]);
+			}
+		}
+
+		for (c = 0; c < COUNTERS; c++)
+		{
+			if (fds[c] >= 0)
+			{
+				ioctl(fds[c], PERF_EVENT_IOC_ENABLE, 0);
+			}
+		}
 	}
+}
 
-	printf("\n");
-	printf("Interlines:         %" PRIu64 "\n", options->interlines);
-	printf("Stoerfunktion:      ");
+/* ************************************************************************ */
+/* countersStop: stops the counters and sums them over threads and ranks    */
+/*                                                                          */
+/* With more events than hardware registers the kernel multiplexes them;    */
+/* every value is scaled by the time it was enabled over the time it ran.   */
+/* A counter only counts as available if every thread on every rank has it. */
+/* ************************************************************************ */
+static void
+countersStop(struct calculation_results* results, struct options const* options)
+{
+	double   local[COUNTERS];
+	int      available[COUNTERS];
+	uint64_t values[3]; /* Wert, Zeit aktiviert, Zeit gelaufen */
+	int      t, c;
 
-	if (options->inf_func == FUNC_F0)
+	for (t = 0; t < (int)options->number; t++)
 	{
-		printf("f(x,y) = 0");
+		for (c = 0; c < COUNTERS; c++)
+		{
+			if (counter_fds[t][c] >= 0)
+			{
+				ioctl(counter_fds[t][c], PERF_EVENT_IOC_DISABLE, 0);
+			}
+		}
 	}
-	else if (options->inf_func == FUNC_FPISIN)
+
+	for (c = 0; c < COUNTERS; c++)
 	{
-		printf("f(x,y) = 2 * pi^2 * sin(pi * x) * sin(pi * y)");
+		local[c]     = 0.0;
+		available[c] = 1;
+
+		for (t = 0; t < (int)options->number; t++)
+		{
+			if (counter_fds[t][c] < 0)
+			{
+				available[c] = 0;
+				continue;
+			}
+
+			if (read(counter_fds[t][c], values, sizeof(values)) == (ssize_t)sizeof(values) && values[2] > 0)
+			{
+				local[c] += (double)values[0] * values[1] / values[2];
+			}
+
+			close(counter_fds[t][c]);
+		}
 	}
 
-	printf("\n");
-	printf("Terminierung:       ");
+	free(counter_fds);
 
-	if (options->termination == TERM_PREC)
+	MPI_Reduce(local, results->counters, COUNTERS, MPI_DOUBLE, MPI_SUM, 0, options->comm);
+	MPI_Reduce(available, results->counted, COUNTERS, MPI_INT, MPI_MIN, 0, options->comm);
+}
+
+/* ************************************************************************ */
+/* comparePlacement: qsort order of the ranks, by node, socket and rank     */
+/* ************************************************************************ */
+static int
+comparePlacement(void const* a, void const* b)
+{
+	struct placement const* x = a;
+	struct placement const* y = b;
+
+	if (x->node != y->node)
 	{
-		printf("Hinreichende Genaugkeit");
+		return x->node - y->node;
 	}
-	else if (options->termination == TERM_ITER)
+
+	if (x->socket != y->socket)
 	{
-		printf("Anzahl der Iterationen");
+		return x->socket - y->socket;
 	}
 
-	printf("\n");
-	printf("Anzahl Iterationen: %" PRIu64 "\n", results->stat_iteration);
-	printf("Norm des Fehlers:   %e\n", results->stat_precision);
-	printf("\n");
+	return x->rank - y->rank;
 }
 
-/****************************************************************************/
-/** Beschreibung der Funktion displayMatrix:                               **/
-/**                                                                        **/
-/** Die Funktion displayMatrix gibt eine Matrix                            **/
-/** in einer "ubersichtlichen Art und Weise auf die Standardausgabe aus.   **/
-/**                                                                        **/
-/** Die "Ubersichtlichkeit wird erreicht, indem nur ein Teil der Matrix    **/
-/** ausgegeben wird. Aus der Matrix werden die Randzeilen/-spalten sowie   **/
-/** sieben Zwischenzeilen ausgegeben.                                      **/
-/****************************************************************************/
+/* ************************************************************************ */
+/* countCrossings: counts neighbour pairs on different nodes (crossings[0]) */
+/*                 and on different sockets of one node (crossings[1])      */
+/* ************************************************************************ */
 static void
-displayMatrix(struct calculation_arguments* arguments, struct calculation_results* results, struct options* options)
+countCrossings(struct placement const* order, int size, int crossings[2])
 {
-	int x, y;
+	int r;
 
-	int const interlines = options->interlines;
-	int const N          = arguments->N;
+	crossings[0] = 0;
+	crossings[1] = 0;
 
-	typedef double(*matrix)[N + 1][N + 1];
+	for (r = 0; r + 1 < size; r++)
+	{
+		if (order[r].node != order[r + 1].node)
+		{
+			crossings[0]++;
+		}
+		else if (order[r].socket != order[r + 1].socket)
+		{
+			crossings[1]++;
+		}
+	}
+}
 
-	matrix Matrix = (matrix)arguments->M;
+/* ************************************************************************ */
+/* placeRanks: orders the ranks so that strip neighbours are close          */
+/*                                                                          */
+/* Every rank reports its node (host name) and socket (physical package of  */
+/* the CPU it runs on, from sysfs). The ranks are sorted by node, in order  */
+/* of first appearance, then by socket, then by their MPI_COMM_WORLD rank.  */
+/* options->comm gets this order and options->rank the new rank, so        */
+/* neighbours ±1 share a socket or node wherever possible. The numbers of   */
+/* neighbour pairs crossing nodes/sockets before and after are recorded.    */
+/* ************************************************************************ */
+static void
+placeRanks(struct options* options)
+{
+	int const size = options->size;
 
-	printf("Matrix:\n");
+	char  host[MPI_MAX_PROCESSOR_NAME] = { 0 };
+	char  path[128];
+	int   socket = 0;
+	int   cpu    = sched_getcpu();
+	int   r, q, position = 0;
+	FILE* file;
 
-	for (y = 0; y < 9; y++)
+	struct placement order[size];
+
+	char* hosts = allocateMemory((size_t)size * MPI_MAX_PROCESSOR_NAME);
+	int   sockets[size];
+
+	gethostname(host, sizeof(host) - 1);
+
+	snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+
+	if (cpu >= 0 && (file = fopen(path, "r")) != NULL)
 	{
-		for (x = 0; x < 9; x++)
+		if (fscanf(file, "%d", &socket) != 1)
 		{
-			printf("%7.4f", Matrix[results->m][y * (interlines + 1)][x * (interlines + 1)]);
+			socket = 0;
 		}
 
-		printf("\n");
+		fclose(file);
 	}
 
-	fflush(stdout);
+	MPI_Allgather(host, MPI_MAX_PROCESSOR_NAME, MPI_CHAR, hosts, MPI_MAX_PROCESSOR_NAME, MPI_CHAR, MPI_COMM_WORLD);
+	MPI_Allgather(&socket, 1, MPI_INT, sockets, 1, MPI_INT, MPI_COMM_WORLD);
+
+	// Knoten nach erstem Auftreten durchnummerieren
+	for (r = 0; r < size; r++)
+	{
+		order[r].node   = r;
+		order[r].socket = sockets[r];
+		order[r].rank   = r;
+
+		for (q = 0; q < r; q++)
+		{
+			if (strcmp(hosts + (size_t)q * MPI_MAX_PROCESSOR_NAME, hosts + (size_t)r * MPI_MAX_PROCESSOR_NAME) == 0)
+			{
+				order[r].node = order[q].node;
+				break;
+			}
+		}
+	}
+
+	free(hosts);
+
+	countCrossings(order, size, options->crossings[0]);
+
+	if (options->reorder)
+	{
+		qsort(order, size, sizeof(order[0]), comparePlacement);
+	}
+
+	countCrossings(order, size, options->crossings[1]);
+
+	for (r = 0; r < size; r++)
+	{
+		if (order[r].rank == options->rank)
+		{
+			position = r;
+		}
+	}
+
+	MPI_Comm_split(MPI_COMM_WORLD, 0, position, &options->comm);
+	MPI_Comm_rank(options->comm, &options->rank);
 }
 
-/*
- * rank und size sind der MPI-Rang und die Größe des Kommunikators
- * from und to stehen für den globalen(!) Bereich von Zeilen für die dieser Prozess zuständig ist
- *
- * Beispiel mit 9 Matrixzeilen und 4 Prozessen:
- * - Rang 0 is verantwortlich für Zeilen 1-2, Rang 1 für 3-4, Rang 2 für 5-6 und Rang 3 für 7
- * - Zeilen 0 und 8 sind nicht inkludiert, weil sie nicht berechnet werden
- * - Jeder Prozess speichert zwei Randzeilen in seiner Matrix
- * - Zum Beispiel: Rang 2 hat vier Zeilen 0-3 aber berechnet nur 1-2 weil 0 und 3 beide Randzeilen für andere Prozesse sind;
- *   Rang 2 ist daher verantwortlich für die globalen Zeilen 5-6
-*/
-static void
-displayMatrixMpi(struct calculation_arguments* arguments, struct calculation_results* results, struct options* options, int rank, int size, int from, int to)
-{
-  int const elements = 8 * options->interlines + 9;
-
-  int x, y;
-
-  typedef double(*matrix)[to - from + 3][arguments->N + 1];
-  matrix Matrix = (matrix)arguments->M;
-  int m = results->m;
-
-  MPI_Status status;
-
-  // Die erste Zeile gehört zu Rang 0
-  if (rank == 0) {
-    from--;
-  }
-
-  // Die letzte Zeile gehört zu Rang (size - 1)
-  if (rank == size - 1) {
-    to++;
-  }
-
-  if (rank == 0) {
-    printf("Matrix:\n");
-  }
-
-  for (y = 0; y < 9; y++)
-  {
-    int line = y * (options->interlines + 1);
-
-    if (rank == 0)
-    {
-      // Prüfen, ob die Zeile zu Rang 0 gehört
-      if (line < from || line > to)
-      {
-        // Der Tag wird genutzt, um Zeilen in der richtigen Reihenfolge zu empfangen
-        // Matrix[m][0] wird überschrieben, da die Werte nicht mehr benötigt werden
-        MPI_Recv(Matrix[m][0], elements, MPI_DOUBLE, MPI_ANY_SOURCE, 42 + y, MPI_COMM_WORLD, &status);
-      }
-    }
-    else
-    {
-      if (line >= from && line <= to)
-      {
-        // Zeile an Rang 0 senden, wenn sie dem aktuellen Prozess gehört
-        // (line - from + 1) wird genutzt, um die lokale Zeile zu berechnen
-        MPI_Send(Matrix[m][line - from + 1], elements, MPI_DOUBLE, 0, 42 + y, MPI_COMM_WORLD);
-      }
-    }
+/* ************************************************************************ */
+/* compareTime: qsort order of the solve times                              */
+/* ************************************************************************ */
+static int
+compareTime(void const* a, void const* b)
+{
+	double const x = *(double const*)a;
+	double const y = *(double const*)b;
 
-    if (rank == 0)
-    {
-      for (x = 0; x < 9; x++)
-      {
-        int col = x * (options->interlines + 1);
+	return (x > y) - (x < y);
+}
 
-        if (line >= from && line <= to)
-        {
-          // Diese Zeile gehört zu Rang 0
-          printf("%7.4f", Matrix[m][line][col]);
-        }
-        else
-        {
-          // Diese Zeile gehört zu einem anderen Rang und wurde weiter oben empfangen
-          printf("%7.4f", Matrix[m][0][col]);
-        }
-      }
+/* ************************************************************************ */
+/* benchStatistics: median, mean and sample standard deviation of count     */
+/* solve times and the 95 % confidence interval of the mean (Student's t),  */
+/* sorts the times                                                          */
+/* ************************************************************************ */
+static void
+benchStatistics(double* times, int count, double* bench)
+{
+	static double const quantiles[BENCH_T] = {
+		12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+		 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+		 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+	};
 
-      printf("\n");
-    }
-  }
+	double sum    = 0.0;
+	double square = 0.0;
+	double t      = 0.0;
+	int    i;
+
+	qsort(times, count, sizeof(times[0]), compareTime);
+
+	bench[0] = (count % 2 == 1) ? times[count / 2] : (times[count / 2 - 1] + times[count / 2]) / 2.0;
+
+	for (i = 0; i < count; i++)
+	{
+		sum += times[i];
+	}
+
+	bench[1] = sum / count;
+
+	for (i = 0; i < count; i++)
+	{
+		square += (times[i] - bench[1]) * (times[i] - bench[1]);
+	}
+
+	// bei einem Lauf gibt es keine Streuung und kein Intervall
+	if (count > 1)
+	{
+		bench[2] = sqrt(square / (count - 1));
+		t        = (count - 1 <= BENCH_T) ? quantiles[count - 2] : 1.96;
+	}
+	else
+	{
+		bench[2] = 0.0;
+	}
 
-  fflush(stdout);
+	bench[3] = bench[1] - t * bench[2] / sqrt(count);
+	bench[4] = bench[1] + t * bench[2] / sqrt(count);
+}
+
+/* ************************************************************************ */
+/* calculate: runs the solver selected by the options                       */
+/* ************************************************************************ */
+static void
+calculate(struct calculation_arguments* arguments, struct calculation_results* results, struct options const* options)
+{
+	if (JACOBI_SWEEPS(options->method) && options->grid[0] != 0)
+	{
+		MPI_jacobi_calculate_cart(arguments, results, options);
+	}
+	else if (options->method == METH_JACOBI && options->balance[0] > 0)
+	{
+		MPI_jacobi_balanced(arguments, results, options);
+	}
+	else if (JACOBI_SWEEPS(options->method) && options->tiles > 0)
+	{
+		MPI_jacobi_tiles(arguments, results, options);
+	}
+	else if (options->method == METH_JACOBI && options->async)
+	{
+		MPI_jacobi_async(arguments, results, options);
+	}
+	else if (options->method == METH_JACOBI && options->depth > 1)
+	{
+		MPI_jacobi_calculate_deep(arguments, results, options);
+	}
+	else if (JACOBI_SWEEPS(options->method))
+	{
+		MPI_jacobi_calculate(arguments, results, options);
+	}
+	else if (options->method == METH_CG)
+	{
+		MPI_cg_calculate(arguments, results, options);
+	}
+	else if (options->method == METH_MULTIGRID)
+	{
+		MPI_multigrid_calculate(arguments, results, options);
+	}
+	else if (options->method == METH_SCHWARZ)
+	{
+		MPI_schwarz_calculate(arguments, results, options);
+	}
+	else
+	{
+		MPI_Gauss_Seidel_calculate(arguments, results, options);
+	}
 }
 
 /* ************************************************************************ */
@@ -885,41 +5646,104 @@ main(int argc, char** argv)
     options.size = -1;
     options.rank = -1;
 
-    // MPI Kram initialisieren
-    MPI_Init(&argc, &argv);
+    // Beginn der Initialisierung, bis zum Start der Berechnung
+    double const setup_start = wallTime();
+
+    // MPI Kram initialisieren, nur der Master-Thread kommuniziert
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
     MPI_Comm_rank(MPI_COMM_WORLD, &(options.rank));
     MPI_Comm_size(MPI_COMM_WORLD, &(options.size));
 
 	askParams(&options, argc, argv);
+	placeRanks(&options);
+
+    if (provided < MPI_THREAD_FUNNELED && options.number > 1) {
+        if (options.rank == 0) {
+            printf("MPI unterstützt keine Threads, es wird nur ein Thread pro Rang benutzt\n");
+        }
+        options.number = 1;
+    }
 
 	initVariables(&arguments, &results, &options);
 
-	allocateMatrices(&arguments);
+	allocateMatrices(&arguments, &options);
 	initMatrices(&arguments, &options);
 
-	gettimeofday(&start_time, NULL);
-    if (options.method == METH_JACOBI) {
-        MPI_jacobi_calculate(&arguments, &results, &options);
-    } else {
-        MPI_Gauss_Seidel_calculate(&arguments, &results, &options);
+	traceInit(&options);
+
+    // mit --bench W + R Läufe auf denselben Matrizen, Zähler und Ausgabe gehören zum letzten
+    int const runs = options.bench[0] + ((options.bench[0] > 0) ? options.bench[1] : 1);
+    double* const times = allocateMemory(runs * sizeof(double));
+    double setup_time = 0.0;
+
+    for (int run = 0; run < runs; run++) {
+        if (run > 0) {
+            // erst neu initialisieren, wenn kein Nachbar mehr unsere Randzeilen liest
+            MPI_Barrier(options.comm);
+            initResults(&results);
+            initMatrices(&arguments, &options);
+            memset(&profile, 0, sizeof(profile));
+        }
+
+        if (options.bench[0] > 0) {
+            MPI_Barrier(options.comm);
+        }
+
+        if (run == runs - 1) {
+            countersStart(&options);
+        }
+
+        gettimeofday(&start_time, NULL);
+        double const solve_start = wallTime();
+
+        if (run == 0) {
+            setup_time = solve_start - setup_start;
+        }
+
+        calculate(&arguments, &results, &options);
+
+        profile.phase[PHASE_TOTAL] = wallTime() - solve_start;
+        gettimeofday(&comp_time, NULL);
+        times[run] = profile.phase[PHASE_TOTAL];
+    }
+
+    if (options.bench[0] > 0) {
+        // ein Lauf dauert so lange wie sein langsamster Rang
+        MPI_Allreduce(MPI_IN_PLACE, times, runs, MPI_DOUBLE, MPI_MAX, options.comm);
+        benchStatistics(times + options.bench[1], options.bench[0], results.bench);
     }
-	gettimeofday(&comp_time, NULL);
+
+    free(times);
+
+    countersStop(&results, &options);
+    reduceProfile(&results, &options);
+    reduceMemory(&arguments, &results, &options);
+    reduceHaloLinks(&arguments, &results, &options);
+    streamRoofline(&results, &options);
+    MPI_Reduce(&setup_time, &results.setup_time, 1, MPI_DOUBLE, MPI_MAX, 0, options.comm);
 
     if (options.rank <= 0) {
 	    displayStatistics(&arguments, &results, &options);
     }
 
-	displayMatrixMpi(&arguments, &results, &options, options.rank, options.size, arguments.row_start + 1, arguments.row_end - 1);
-/*
-    if (options.method == METH_JACOBI) {
-        displayMatrixMpi(&arguments, &results, &options, options.rank, options.size, arguments.row_start + 1, arguments.row_end - 1);
-    } else {
-        displayMatrix(&arguments, &results, &options);
+	displayMatrixMpi(&arguments, &results, &options);
+
+    if (options.preview > 0) {
+        writePreview(&arguments, &results, &options, options.preview, "partdiff_preview.dat");
+    }
+
+    traceWrite(&options, "partdiff_trace.json");
+
+    if (arguments.comm != options.comm) {
+        MPI_Comm_free(&arguments.comm);
     }
-*/
-    MPI_Finalize();
 
 	freeMatrices(&arguments);
 
+    MPI_Comm_free(&options.comm);
+
+    MPI_Finalize();
+
 	return 0;
 }